@@ -26,7 +26,180 @@ void data_geth( PL011_t* d,       uint8_t* x, int n, bool f ) {
   }
 }
 
+int     disk_mode   = DISK_MODE_HEX;
+uint8_t disk_tag    = 0;
+bool    disk_vector = false; // true once the disk has answered a conf with a mode (so knows vector requests)
+
+void data_put( PL011_t* d, const uint8_t* x, int n, bool f ) {
+  for( int i = 0; i < n; i++ ) {
+    PL011_putc( d, x[ i ], f );
+  }
+}
+
+uint16_t data_crc( uint16_t crc, const uint8_t* x, int n ) {
+  for( int i = 0; i < n; i++ ) {
+    crc ^= ( uint16_t )( x[ i ] ) << 8;
+
+    for( int j = 0; j < 8; j++ ) {
+      crc = ( crc & 0x8000 ) ? ( ( crc << 1 ) ^ 0x1021 ) : ( crc << 1 );
+    }
+  }
+
+  return crc;
+}
+
+int  iov_len( const disk_iov_t* iov, int count ) {
+  int n = 0;
+
+  for( int i = 0; i < count; i++ ) {
+    n += iov[ i ].len;
+  }
+
+  return n;
+}
+
+// copy n bytes between b and the buffers of iov, from byte *k of buffer *j on (into iov if in, else out of it)
+void iov_copy( const disk_iov_t* iov, int count, int* j, int* k, uint8_t* b, int n, bool in ) {
+  for( int i = 0; i < n && *j < count; ) {
+    if( *k == iov[ *j ].len ) {
+      *j += 1; *k = 0;
+    }
+    else if( in ) {
+      iov[ *j ].base[ ( *k )++ ] = b[ i++ ];
+    }
+    else {
+      b[ i++ ] = iov[ *j ].base[ ( *k )++ ];
+    }
+  }
+}
+
+// write a frame whose payload is the n bytes of x followed by the buffers of iov
+void frame_put( PL011_t* d, uint8_t cmd, uint8_t tag, const uint8_t* x, int n, const disk_iov_t* iov, int count ) {
+  int m = n + iov_len( iov, count );
+  uint8_t h[ 4 ] = { cmd, tag, m & 0xFF, ( m >> 8 ) & 0xFF };
+
+  uint16_t crc = data_crc( data_crc( 0xFFFF, h, 4 ), x, n );
+  for( int i = 0; i < count; i++ ) {
+    crc = data_crc( crc, iov[ i ].base, iov[ i ].len );
+  }
+
+  data_put( d, h, 4, true );                  // write header
+  data_put( d, x, n, true );                  // write payload
+  for( int i = 0; i < count; i++ ) {
+    data_put( d, iov[ i ].base, iov[ i ].len, true );
+  }
+  PL011_putc( d, ( crc >> 0 ) & 0xFF, true ); // write CRC
+  PL011_putc( d, ( crc >> 8 ) & 0xFF, true );
+}
+
+// read a frame, scattering its payload over the buffers of iov (dropping any more); return its command, or -1 if the tag or CRC is wrong
+int  frame_get( PL011_t* d, uint8_t tag, const disk_iov_t* iov, int count, int* len ) {
+  uint8_t h[ 4 ];
+
+  for( int i = 0; i < 4; i++ ) {              // read  header
+    h[ i ] = PL011_getc( d, true );
+  }
+
+  uint16_t crc = data_crc( 0xFFFF, h, 4 );
+  *len = h[ 2 ] | ( h[ 3 ] << 8 );
+
+  int j = 0, k = 0;
+
+  for( int i = 0; i < *len; i++ ) {           // read  payload
+    uint8_t c = PL011_getc( d, true );
+    crc = data_crc( crc, &c, 1 );
+
+    iov_copy( iov, count, &j, &k, &c, 1, true );
+  }
+
+  uint16_t r  = PL011_getc( d, true ) << 0;   // read  CRC
+           r |= PL011_getc( d, true ) << 8;
+
+  return ( r == crc && h[ 1 ] == tag ) ? h[ 0 ] : -1;
+}
+
+// make a request with payload x then the buffers of out, returning true once it is acknowledged okay with exactly enough payload to fill in
+bool frame_req( uint8_t cmd, const uint8_t* x, int n, const disk_iov_t* out, int outs, const disk_iov_t* in, int ins ) {
+  for( int i = 0; i < DISK_RETRY; i++ ) {
+    uint8_t tag = disk_tag++; int len;
+
+    frame_put( UART2, cmd, tag, x, n, out, outs );
+
+    if( frame_get( UART2, tag, in, ins, &len ) == 0x00 && len == iov_len( in, ins ) ) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+int disk_conf( int mode ) {
+  uint8_t x[ 2 * sizeof( uint32_t ) + 1 ]; disk_iov_t v = { x, sizeof( x ) };
+
+  if( mode == disk_mode ) {
+    return disk_mode;
+  }
+
+  if( disk_mode == DISK_MODE_BIN ) {
+    uint8_t m = mode;                         // conf with a mode: the geometry, then the mode now in use
+
+    if( frame_req( 0x00, &m, 1, NULL, 0, &v, 1 ) ) {
+      disk_mode = x[ sizeof( x ) - 1 ];
+    }
+
+    return disk_mode;
+  }
+
+  for( int i = 0; i < DISK_RETRY; i++ ) {
+      PL011_puth( UART2, 0x00, true );        // write command
+      PL011_putc( UART2, ' ',  true );        // write separator
+      PL011_puth( UART2, mode, true );        // write mode
+      PL011_putc( UART2, '\n', true );        // write EOL
+
+    if( PL011_geth( UART2, true ) == 0x00 ) { // read  command
+      PL011_getc( UART2,       true );        // read  separator
+      int n = 0;                              // read  data (a hex-only disk sends no mode)
+      for( char c = PL011_getc( UART2, true ); c != '\n'; c = PL011_getc( UART2, true ) ) {
+        uint8_t r = ( xtoi( c ) << 4 ) | xtoi( PL011_getc( UART2, true ) );
+
+        if( n < ( int )( sizeof( x ) ) ) {
+          x[ n ] = r;
+        }
+        n++;
+      }
+
+      if( n == ( int )( sizeof( x ) ) ) {
+        disk_vector = true;
+      }
+      if( n == ( int )( sizeof( x ) ) && x[ n - 1 ] == mode ) {
+        disk_mode = mode;
+      }
+
+      return disk_mode;
+    }
+    else {
+      PL011_getc( UART2,       true );        // read  EOL
+    }
+  }
+
+  return disk_mode;
+}
+
 int disk_get_block_num() {
+  if( disk_mode == DISK_MODE_BIN ) {
+    uint8_t x[ 2 * sizeof( uint32_t ) ]; disk_iov_t v = { x, sizeof( x ) };
+
+    if( !frame_req( 0x00, NULL, 0, NULL, 0, &v, 1 ) ) {
+      return DISK_FAILURE;
+    }
+
+    return ( ( uint32_t )( x[ 0 ] ) <<  0 ) |
+           ( ( uint32_t )( x[ 1 ] ) <<  8 ) |
+           ( ( uint32_t )( x[ 2 ] ) << 16 ) |
+           ( ( uint32_t )( x[ 3 ] ) << 24 ) ;
+  }
+
+
   int n = 2 * sizeof( uint32_t ); uint8_t x[ n ];
 
   for( int i = 0; i < DISK_RETRY; i++ ) {
@@ -52,6 +225,20 @@ int disk_get_block_num() {
 }
 
 int disk_get_block_len() {
+  if( disk_mode == DISK_MODE_BIN ) {
+    uint8_t x[ 2 * sizeof( uint32_t ) ]; disk_iov_t v = { x, sizeof( x ) };
+
+    if( !frame_req( 0x00, NULL, 0, NULL, 0, &v, 1 ) ) {
+      return DISK_FAILURE;
+    }
+
+    return ( ( uint32_t )( x[ 4 ] ) <<  0 ) |
+           ( ( uint32_t )( x[ 5 ] ) <<  8 ) |
+           ( ( uint32_t )( x[ 6 ] ) << 16 ) |
+           ( ( uint32_t )( x[ 7 ] ) << 24 ) ;
+  }
+
+
   int n = 2 * sizeof( uint32_t ); uint8_t x[ n ];
 
   for( int i = 0; i < DISK_RETRY; i++ ) {
@@ -77,6 +264,15 @@ int disk_get_block_len() {
 }
 
 int disk_wr( uint32_t a, const uint8_t* x, int n ) {
+  if( disk_mode == DISK_MODE_BIN ) {
+    uint8_t y[ 4 ] = { ( a >> 0 ) & 0xFF, ( a >> 8 ) & 0xFF, ( a >> 16 ) & 0xFF, ( a >> 24 ) & 0xFF };
+
+    disk_iov_t v = { ( uint8_t* )( x ), n };
+
+    return frame_req( 0x01, y, 4, &v, 1, NULL, 0 ) ? DISK_SUCCESS : DISK_FAILURE;
+  }
+
+
   for( int i = 0; i < DISK_RETRY; i++ ) {
       PL011_puth( UART2, 0x01, true );        // write command
       PL011_putc( UART2, ' ',  true );        // write separator
@@ -99,6 +295,15 @@ int disk_wr( uint32_t a, const uint8_t* x, int n ) {
 }
 
 int disk_rd( uint32_t a,       uint8_t* x, int n ) {
+  if( disk_mode == DISK_MODE_BIN ) {
+    uint8_t y[ 4 ] = { ( a >> 0 ) & 0xFF, ( a >> 8 ) & 0xFF, ( a >> 16 ) & 0xFF, ( a >> 24 ) & 0xFF };
+
+    disk_iov_t v = { x, n };
+
+    return frame_req( 0x02, y, 4, NULL, 0, &v, 1 ) ? DISK_SUCCESS : DISK_FAILURE;
+  }
+
+
   for( int i = 0; i < DISK_RETRY; i++ ) {
       PL011_puth( UART2, 0x02, true );        // write command
       PL011_putc( UART2, ' ',  true );        // write separator
@@ -119,3 +324,114 @@ int disk_rd( uint32_t a,       uint8_t* x, int n ) {
 
   return DISK_FAILURE;
 }
+
+// a disk that doesn't know vector requests: move the blocks one at a time through b
+int disk_blockv( uint32_t a, const disk_iov_t* iov, int count, bool wr ) {
+  int n = disk_get_block_len(), total = iov_len( iov, count ), j = 0, k = 0;
+
+  if( n <= 0 || total % n != 0 ) {
+    return DISK_FAILURE;
+  }
+
+  uint8_t b[ n ];
+
+  for( int i = 0; i < total / n; i++ ) {
+    if( wr ) {
+      iov_copy( iov, count, &j, &k, b, n, false );
+
+      if( disk_wr( a + i, b, n ) != DISK_SUCCESS ) {
+        return DISK_FAILURE;
+      }
+    }
+    else {
+      if( disk_rd( a + i, b, n ) != DISK_SUCCESS ) {
+        return DISK_FAILURE;
+      }
+
+      iov_copy( iov, count, &j, &k, b, n, true  );
+    }
+  }
+
+  return DISK_SUCCESS;
+}
+
+int disk_wrv( uint32_t a, const disk_iov_t* iov, int count ) {
+  int n = iov_len( iov, count );
+
+  if( n > DISK_VEC_MAX ) {
+    return DISK_FAILURE;
+  }
+  if( !disk_vector ) {
+    return disk_blockv( a, iov, count, true  );
+  }
+
+  if( disk_mode == DISK_MODE_BIN ) {
+    uint8_t y[ 4 ] = { ( a >> 0 ) & 0xFF, ( a >> 8 ) & 0xFF, ( a >> 16 ) & 0xFF, ( a >> 24 ) & 0xFF };
+
+    return frame_req( 0x04, y, 4, iov, count, NULL, 0 ) ? DISK_SUCCESS : DISK_FAILURE;
+  }
+
+  for( int i = 0; i < DISK_RETRY; i++ ) {
+      PL011_puth( UART2, 0x04, true );        // write command
+      PL011_putc( UART2, ' ',  true );        // write separator
+       addr_puth( UART2, a,    true );        // write address
+      PL011_putc( UART2, ' ',  true );        // write separator
+    for( int j = 0; j < count; j++ ) {        // write data
+       data_puth( UART2, iov[ j ].base, iov[ j ].len, true );
+    }
+      PL011_putc( UART2, '\n', true );        // write EOL
+
+    if( PL011_geth( UART2, true ) == 0x00 ) { // read  command
+      PL011_getc( UART2,       true );        // read  EOL
+
+      return DISK_SUCCESS;
+    }
+    else {
+      PL011_getc( UART2,       true );        // read  EOL
+    }
+  }
+
+  return DISK_FAILURE;
+}
+
+int disk_rdv( uint32_t a, const disk_iov_t* iov, int count ) {
+  int n = iov_len( iov, count );
+
+  if( n > DISK_VEC_MAX ) {
+    return DISK_FAILURE;
+  }
+  if( !disk_vector ) {
+    return disk_blockv( a, iov, count, false );
+  }
+
+  if( disk_mode == DISK_MODE_BIN ) {
+    uint8_t y[ 8 ] = { ( a >> 0 ) & 0xFF, ( a >> 8 ) & 0xFF, ( a >> 16 ) & 0xFF, ( a >> 24 ) & 0xFF,
+                       ( n >> 0 ) & 0xFF, ( n >> 8 ) & 0xFF, ( n >> 16 ) & 0xFF, ( n >> 24 ) & 0xFF };
+
+    return frame_req( 0x03, y, 8, NULL, 0, iov, count ) ? DISK_SUCCESS : DISK_FAILURE;
+  }
+
+  for( int i = 0; i < DISK_RETRY; i++ ) {
+      PL011_puth( UART2, 0x03, true );        // write command
+      PL011_putc( UART2, ' ',  true );        // write separator
+       addr_puth( UART2, a,    true );        // write address
+      PL011_putc( UART2, ' ',  true );        // write separator
+       addr_puth( UART2, n,    true );        // write length
+      PL011_putc( UART2, '\n', true );        // write EOL
+
+    if( PL011_geth( UART2, true ) == 0x00 ) { // read  command
+      PL011_getc( UART2,       true );        // read  separator
+    for( int j = 0; j < count; j++ ) {        // read  data
+       data_geth( UART2, iov[ j ].base, iov[ j ].len, true );
+    }
+      PL011_getc( UART2,       true );        // read  EOL
+
+      return DISK_SUCCESS;
+    }
+    else {
+      PL011_getc( UART2,       true );        // read  EOL
+    }
+  }
+
+  return DISK_FAILURE;
+}
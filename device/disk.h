@@ -30,6 +30,40 @@
 #define DISK_SUCCESS (  0 )
 #define DISK_FAILURE ( -1 )
 
+/* Two protocol versions are spoken over UART2: the original one, where
+ * each request and acknowledgement is a line of hex digits, and binary
+ * frames
+ *
+ * [ command | tag | length (2 bytes) | payload (length bytes) | CRC (2 bytes) ]
+ *
+ * where multi-byte fields are little-endian, the tag of a request is
+ * echoed by its acknowledgement, and the CRC (CRC-16/CCITT, initial
+ * value 0xFFFF) covers everything before it; no byte is escaped, since
+ * the length says where each frame ends. The disk starts in hex mode,
+ * and disk_conf asks it to change (a disk that only speaks hex ignores
+ * the request, so the mode stays hex).
+ */
+
+#define DISK_MODE_HEX  (  1 )
+#define DISK_MODE_BIN  (  2 )
+
+/* A vector request moves a range of contiguous blocks in one request
+ * and acknowledgement, gathered from (or scattered over) the buffers of
+ * an iov array; the buffers must add up to a whole number of blocks,
+ * and at most DISK_VEC_MAX bytes. A disk that only speaks hex is sent
+ * the blocks one request at a time instead.
+ */
+
+#define DISK_VEC_MAX   ( 4096 )
+
+typedef struct {
+  uint8_t* base;
+  int      len;
+} disk_iov_t;
+
+// ask the disk to switch to protocol mode, returning the mode now in use
+extern int disk_conf( int mode );
+
 // query the disk block count
 extern int disk_get_block_num();
 // query the disk block length
@@ -40,4 +74,9 @@ extern int disk_wr( uint32_t a, const uint8_t* x, int n );
 // read  an n-byte block of data x from the disk at block address a
 extern int disk_rd( uint32_t a,       uint8_t* x, int n );
 
+// write the buffers of iov to   the disk from block address a on
+extern int disk_wrv( uint32_t a, const disk_iov_t* iov, int count );
+// read  the buffers of iov from the disk from block address a on
+extern int disk_rdv( uint32_t a, const disk_iov_t* iov, int count );
+
 #endif
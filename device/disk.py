@@ -9,19 +9,88 @@ import argparse, binascii, logging, os, socket, struct, sys
 REQ_CONF = '00'
 REQ_WR   = '01'
 REQ_RD   = '02'
+REQ_RDV  = '03'
+REQ_WRV  = '04'
 
 ACK_OKAY = '00'
 ACK_FAIL = '01'
 
+# protocol modes (see disk.h): lines of hex digits, or binary frames
+
+MODE_HEX = 1
+MODE_BIN = 2
+
 # 00 command means a query operation: we pack the block size 
-# and count into a single datum, then return it.
+# and count into a single datum, then return it.  If a mode is
+# requested too, the mode in use after this acknowledgement is
+# appended (a mode we don't know leaves it unchanged).
 
 def conf( fd, req ) :
+  global mode
+
   data  = struct.pack( '<l', args.block_num )
   data += struct.pack( '<l', args.block_len )
 
+  if ( len( req ) > 1 ) :
+    if ( int( req[ 1 ], 16 ) in [ MODE_HEX, MODE_BIN ] ) :
+      mode = int( req[ 1 ], 16 )
+
+    data += struct.pack( '<B', mode )
+
   return [ ACK_OKAY, data ]
 
+# the read and write operations themselves, shared by both modes:
+# a range of whole blocks from address on, moved with one pwrite or
+# pread (emulated with lseek where os lacks them)
+
+def range_ok( address, n ) :
+  return n > 0 and n % args.block_len == 0 and address >= 0 and address + n // args.block_len <= args.block_num
+
+def range_wr( fd, address, data ) :
+  if( not range_ok( address, len( data ) ) ) :
+    return False
+
+  if ( hasattr( os, 'pwrite' ) ) :
+    n = os.pwrite( fd, data, address * args.block_len )
+  else :
+    os.lseek( fd, address * args.block_len, os.SEEK_SET ) ; n = os.write( fd, data )
+
+  if( len( data ) != n              ) :
+    return False
+
+  os.fsync( fd )
+
+  logging.info( 'wr %d bytes -> address %X_{(16)} = %d_{(10)}' % ( len( data ), address, address ) )
+  logging.debug( 'wr data = %s' % ( binascii.hexlify( data ) ) )
+
+  return True
+
+def range_rd( fd, address, n ) :
+  if( not range_ok( address, n ) ) :
+    return None
+
+  if ( hasattr( os, 'pread' ) ) :
+    data = os.pread( fd, n, address * args.block_len )
+  else :
+    os.lseek( fd, address * args.block_len, os.SEEK_SET ) ; data = os.read( fd, n )
+
+  if( len( data ) != n              ) :
+    return None
+
+  logging.info( 'rd %d bytes <- address %X_{(16)} = %d_{(10)}' % ( len( data ), address, address ) )
+  logging.debug( 'rd data = %s' % ( binascii.hexlify( data ) ) )
+
+  return data
+
+def block_wr( fd, address, data ) :
+  if( len( data ) != args.block_len ) :
+    return False
+
+  return range_wr( fd, address, data )
+
+def block_rd( fd, address ) :
+  return range_rd( fd, address, args.block_len )
+
 # 01 command means a write operation:
 # - if the address provided is invalid the request fails,
 # - if the data    provided is invalid the request fails, 
@@ -31,22 +100,9 @@ def   wr( fd, req ) :
   address = struct.unpack( '<l', binascii.unhexlify( req[ 1 ] ) )[ 0 ]
   data    =                      binascii.unhexlify( req[ 2 ] )
 
-  if( address     >= args.block_num ) :
-    return [ ACK_FAIL ]
-  if( len( data ) != args.block_len ) :
-    return [ ACK_FAIL ]
-
-  os.lseek( fd, address * args.block_len, os.SEEK_SET ) 
-  n = os.write( fd, data )
-
-  if( len( data ) != n              ) :
+  if( not block_wr( fd, address, data ) ) :
     return [ ACK_FAIL ]
 
-  os.fsync( fd )
-
-  logging.info( 'wr %d bytes -> address %X_{(16)} = %d_{(10)}' % ( len( data ), address, address ) )
-  logging.debug( 'wr data = %s' % ( ''.join( [ '%02X' % ( ord( x ) ) for x in data ] ) ) )
-
   return [ ACK_OKAY       ]
 
 # 02 command means a read  operation:
@@ -55,23 +111,79 @@ def   wr( fd, req ) :
 
 def   rd( fd, req ) :
   address = struct.unpack( '<l', binascii.unhexlify( req[ 1 ] ) )[ 0 ]
+  data    = block_rd( fd, address )
 
-  if( address     >= args.block_num ) :
+  if( data is None ) :
     return [ ACK_FAIL ]
 
-  os.lseek( fd, address * args.block_len, os.SEEK_SET )
-  data = os.read( fd, args.block_len )
+  return [ ACK_OKAY, data ]
 
-  if( len( data ) != args.block_len ) :
-    return [ ACK_FAIL ]
+# 03 command means a vector read  operation: the range of blocks
+# holding the given number of bytes from address on is read and
+# returned; 04 command means a vector write operation: the data
+# (a whole number of blocks) is written from address on.
 
-  os.fsync( fd )
+def  rdv( fd, req ) :
+  address = struct.unpack( '<l', binascii.unhexlify( req[ 1 ] ) )[ 0 ]
+  n       = struct.unpack( '<l', binascii.unhexlify( req[ 2 ] ) )[ 0 ]
+  data    = range_rd( fd, address, n )
 
-  logging.info( 'rd %d bytes <- address %X_{(16)} = %d_{(10)}' % ( len( data ), address, address ) )
-  logging.debug( 'rd data = %s' % ( ''.join( [ '%02X' % ( ord( x ) ) for x in data ] ) ) )
+  if( data is None ) :
+    return [ ACK_FAIL ]
 
   return [ ACK_OKAY, data ]
 
+def  wrv( fd, req ) :
+  address = struct.unpack( '<l', binascii.unhexlify( req[ 1 ] ) )[ 0 ]
+  data    =                      binascii.unhexlify( req[ 2 ] )
+
+  if( not range_wr( fd, address, data ) ) :
+    return [ ACK_FAIL ]
+
+  return [ ACK_OKAY       ]
+
+# In binary mode each request is a frame (see disk.h)
+#
+# [ command | tag | length | payload | CRC ]
+#
+# and so is each acknowledgement, which echoes the tag; a request
+# whose CRC is wrong is failed (the kernel then retries it).
+
+def crc( data ) :
+  return binascii.crc_hqx( data, 0xFFFF )
+
+def frame_get( sd ) :
+  head = sd.read( 4 )
+  cmd, tag, n = struct.unpack( '<BBH', head )
+  data = sd.read( n )
+  ok   = struct.unpack( '<H', sd.read( 2 ) )[ 0 ] == crc( head + data )
+
+  return ok, cmd, tag, data
+
+def frame_put( sd, cmd, tag, data ) :
+  frame  = struct.pack( '<BBH', cmd, tag, len( data ) ) + data
+  frame += struct.pack( '<H', crc( frame ) )
+
+  sd.write( frame ) ; sd.flush()
+
+def frame_ack( fd, cmd, data ) :
+  global mode
+
+  if   ( cmd == int( REQ_CONF, 16 ) ) :
+    ack = conf( fd, [ REQ_CONF ] + [ '%02X' % ( x ) for x in bytearray( data[ : 1 ] ) ] )[ 1 ]
+  elif ( cmd == int( REQ_WR,   16 ) and len( data ) >= 4 ) :
+    ack = b'' if block_wr( fd, struct.unpack( '<l', data[ : 4 ] )[ 0 ], data[ 4 : ] ) else None
+  elif ( cmd == int( REQ_RD,   16 ) and len( data ) == 4 ) :
+    ack = block_rd( fd, struct.unpack( '<l', data[ : 4 ] )[ 0 ] )
+  elif ( cmd == int( REQ_RDV,  16 ) and len( data ) == 8 ) :
+    ack = range_rd( fd, *struct.unpack( '<ll', data ) )
+  elif ( cmd == int( REQ_WRV,  16 ) and len( data ) >= 4 ) :
+    ack = b'' if range_wr( fd, struct.unpack( '<l', data[ : 4 ] )[ 0 ], data[ 4 : ] ) else None
+  else :
+    ack = None
+
+  return ack
+
 # The command line interface basically just parses the arguments
 # which configure the disk etc. then enters an infinite loop: it
 # reads requests and writes acknowledgements one at a time until
@@ -108,12 +220,28 @@ if ( __name__ == '__main__' ) :
 
   s = socket.socket( socket.AF_INET, socket.SOCK_STREAM )
   
-  s.connect( ( args.host, args.port ) ) ; sd = s.makefile()
+  s.connect( ( args.host, args.port ) ) ; sd = s.makefile( 'rwb' )
 
   # read request, process it and write acknowledgement
   
+  mode = MODE_HEX
+
   while ( True ) :
-    req = sd.readline().strip().split( ' ' )
+    if ( mode == MODE_BIN ) :
+      ok, cmd, tag, data = frame_get( sd )
+
+      logging.debug( 'req = %02X %02X %s' % ( cmd, tag, binascii.hexlify( data ) ) )
+
+      ack = frame_ack( fd, cmd, data ) if ok else None
+
+      if ( ack is None ) :
+        frame_put( sd, int( ACK_FAIL, 16 ), tag, b'' )
+      else :
+        frame_put( sd, int( ACK_OKAY, 16 ), tag, ack )
+
+      continue
+
+    req = sd.readline().decode( 'ascii' ).strip().split( ' ' )
 
     logging.debug( 'req = ' + str( req ) )  
   
@@ -123,17 +251,21 @@ if ( __name__ == '__main__' ) :
       ack =   wr( fd, req )
     elif ( req[ 0 ] == REQ_RD   ) :
       ack =   rd( fd, req )
+    elif ( req[ 0 ] == REQ_RDV  ) :
+      ack =  rdv( fd, req )
+    elif ( req[ 0 ] == REQ_WRV  ) :
+      ack =  wrv( fd, req )
     else :
       ack = [ ACK_FAIL ]
 
     logging.debug( 'ack = ' + str( ack ) )
 
     if ( len( ack ) > 1 ) :
-      ack = ack[ 0 ] + ' ' + ' '.join( [ binascii.hexlify( x ) for x in ack[ 1 : ] ] )
+      ack = ack[ 0 ] + ' ' + ' '.join( [ binascii.hexlify( x ).decode( 'ascii' ) for x in ack[ 1 : ] ] )
     else :
       ack = ack[ 0 ]
 
-    sd.write( ack + '\n' ) ; sd.flush()
+    sd.write( ( ack + '\n' ).encode( 'ascii' ) ) ; sd.flush()
   
   # close network connection
 
@@ -13,6 +13,19 @@
 #include "../scheduling/scheduler.h"
 #include "../ipc/shmTable.h"
 #include "../ipc/semTable.h"
+#include "../ipc/futex.h"
+#include "../ipc/mutexTable.h"
+#include "../ipc/syncTable.h"
+#include "../ipc/pipeTable.h"
+#include "../ipc/ipcCall.h"
+#include "../ipc/pollTable.h"
+#include "../io/uart.h"
+#include "../io/fdTable.h"
+#include "../io/ioRing.h"
+#include "../memory/slab.h"
+#include "../memory/buddy.h"
+#include "../memory/kheap.h"
+#include "../memory/userHeap.h"
 #include "../../user/console.h"
 
 extern void main_console();
@@ -71,10 +84,25 @@ void hilevel_handler_rst(ctx_t *ctx)
   //  initialise variables
   PROCS_ACTIVE = 0;
   PROCS = 0;
-  for (int i = 0; i < procTabSize; i++)
-  {
-    procTable[i].status = STATUS_INVALID;
-  }
+  //  size every process table at boot (nothing is resized afterwards)
+  procTableInit();
+  procHistoryTableInit();
+  //  hand the RAM above the kernel image to the page allocator
+  pageInit();
+  handleTableInit();
+  //  create the IPC object caches
+  semTableInit();
+  futexTableInit();
+  mutexTableInit();
+  syncTableInit();
+  pipeTableInit();
+  ipcTableInit();
+  pollTableInit();
+  shmTableInit();
+  //  mask the UARTs until there is output to drain
+  uartInit();
+  fdTableInit();
+  ioTableInit();
   //  invoke and malloc the MLFQ
   invokeQueueMLFQ();
 
@@ -98,11 +126,10 @@ void hilevel_handler_rst(ctx_t *ctx)
   TIMER0->Timer1Ctrl |= 0x00000040; // select periodic timer
   TIMER0->Timer1Ctrl |= 0x00000020; // enable          timer interrupt
   TIMER0->Timer1Ctrl |= 0x00000080; // enable          timer
-  //UART0->IMSC       |= 0x00000010; // enable UART    (Rx) interrupt
-  //UART0->CR          = 0x00000301; // enable UART (Tx+Rx)
   GICC0->PMR = 0x000000F0;         // unmask all          interrupts
-  GICD0->ISENABLER0 |= 0x00000010; // enable UART    (Rx) interrupt
-  GICD0->ISENABLER1 |= 0x00000010; // enable UART    (Rx) interrupt
+  GICD0->ISENABLER1 |= 0x00000010; // enable timer          interrupt
+  GICD0->ISENABLER1 |= 0x00001000; // enable UART0          interrupt
+  GICD0->ISENABLER1 |= 0x00002000; // enable UART1          interrupt
   GICC0->CTLR = 0x00000001;        // enable GIC interface
   GICD0->CTLR = 0x00000001;        // enable GIC distributor
 
@@ -118,20 +145,25 @@ void hilevel_handler_irq(ctx_t *ctx)
   // handle the interrupt, then clear (or reset) the source.
   if (id == GIC_SOURCE_UART0)
   {
-    uint8_t x = PL011_getc(UART0, true);
+    uartIrq(&uartTable[0]);
+    ioPoll();
+  }
 
-    PL011_putc(UART0, 'K', true);
-    PL011_putc(UART0, '<', true);
-    PL011_putc(UART0, itox((x >> 4) & 0xF), true);
-    PL011_putc(UART0, itox((x >> 0) & 0xF), true);
-    PL011_putc(UART0, '>', true);
+  if (id == GIC_SOURCE_UART1)
+  {
+    uartIrq(&uartTable[1]);
+    ioPoll();
   }
 
   if (id == GIC_SOURCE_TIMER0)
   {
     //  schedule every tick
-    PL011_putc(UART0, 'T', true);
+    uartPutc(&uartTable[0], 'T');
     TIMER0->Timer1IntClr = 0x01;
+    pollTimers();
+    uartTimers();
+    pipeTimers();
+    ioTick();
     schedule(ctx);
   }
 
@@ -141,8 +173,31 @@ void hilevel_handler_irq(ctx_t *ctx)
   return;
 }
 
+/*  release everything the process with the given PID holds (ring, descriptors, waits, locks, pipes,
+    semaphores, segments), then take it off the MLFQ and delete its procTable entry  */
+void procTeardown(pid_t pid)
+{
+  ioTableRemove(pid);
+  fdTableRemove(pid);
+  uartTableRemove(pid);
+  pollTableRemove(pid);
+  mutexTableRemove(pid);
+  syncTableRemove(pid);
+  pipeTableRemove(pid);
+  ipcTableRemove(pid);
+  semTableRemove(pid);
+  shmTabRemove(pid);
+  removeFromMLFQ(pid);
+  procDelete(pid);
+  return;
+}
+
 void hilevel_handler_svc(ctx_t *ctx, uint32_t id)
 {
+  pcb_t *caller = currentProc;
+  //  wakes from interrupts (e.g., poll timeouts) are left to the scheduler
+  scheduleWoken = NULL;
+
   switch (id)
   {
   case 0x00:
@@ -156,32 +211,37 @@ void hilevel_handler_svc(ctx_t *ctx, uint32_t id)
   case 0x01:
   { // 0x01 => write( fd, x, n )
     int fd = (int)(ctx->gpr[0]);
-    char *x = (char *)(ctx->gpr[1]);
-    int n = (int)(ctx->gpr[2]);
+    uint8_t *x = (uint8_t *)(ctx->gpr[1]);
+    size_t n = (size_t)(ctx->gpr[2]);
+    file_t *file = fdLookup(currentProc, fd);
 
-    for (int i = 0; i < n; i++)
+    if (file != NULL)
     {
-      PL011_putc(UART0, *x++, true);
+      file->ops->write(ctx, currentProc, file, x, n, 0);
+    }
+    else
+    {
+      ctx->gpr[0] = -1;
     }
-
-    ctx->gpr[0] = n;
-
     break;
   }
 
   case 0x02:
-  { // 0x02 => read( fd, x, n )
+  { // 0x02 => read( fd, x, n, timeout )
     int fd = (int)(ctx->gpr[0]);
-    char *x = (char *)(ctx->gpr[1]);
-    int n = (int)(ctx->gpr[2]);
+    uint8_t *x = (uint8_t *)(ctx->gpr[1]);
+    size_t n = (size_t)(ctx->gpr[2]);
+    int timeout = (int)(ctx->gpr[3]);
+    file_t *file = fdLookup(currentProc, fd);
 
-    for (int i = 0; i < n; i++)
+    if (file != NULL)
     {
-      PL011_getc(UART0, true);
+      file->ops->read(ctx, currentProc, file, x, n, timeout);
+    }
+    else
+    {
+      ctx->gpr[0] = -1;
     }
-
-    ctx->gpr[0] = n;
-
     break;
   }
 
@@ -191,9 +251,15 @@ void hilevel_handler_svc(ctx_t *ctx, uint32_t id)
     {
       //  disable scheduling
       //disableMLFQ();
-      currentProc->status = STATUS_READY;
       memcpy(&currentProc->ctx, ctx, sizeof(ctx_t));
       pid_t pidChild = procCopy(currentProc, ctx);
+      if (pidChild < 0)
+      {
+        kputs("error: out of memory\n", 21);
+        ctx->gpr[0] = -1;
+        break;
+      }
+      currentProc->status = STATUS_READY;
       currentProc->ctx.gpr[0] = pidChild;
       dispatch(ctx, currentProc, &procTable[procTableContains(pidChild)]);
       PROCS_ACTIVE++;
@@ -201,7 +267,7 @@ void hilevel_handler_svc(ctx_t *ctx, uint32_t id)
     else
     {
       //  TODO MMU
-      puts("error: exceeded MAX_PROCS\n", 26);
+      kputs("error: exceeded MAX_PROCS\n", 26);
       //  return -1 as error value
       ctx->gpr[0] = -1;
     }
@@ -218,29 +284,23 @@ void hilevel_handler_svc(ctx_t *ctx, uint32_t id)
     {
       if (exitStatus == EXIT_SUCCESS)
       {
-        semTableRemove(pid);
-        shmTabRemove(pid);
         //  remove process from queue and delete process table entry and reschedule next process
-        removeFromMLFQ(pid);
-        procDelete(pid);
+        procTeardown(pid);
         schedule(ctx);
       }
       else
       {
-        semTableRemove(pid);
-        shmTabRemove(pid);
         //  same as above but store in history table
         procHistoryInit(&procTable[procTableContains(pid)]);
-        removeFromMLFQ(pid);
-        procDelete(pid);
-        puts("console$ process killed and stored in history table\n", 52);
+        procTeardown(pid);
+        kputs("console$ process killed and stored in history table\n", 52);
         schedule(ctx);
       }
       PROCS_ACTIVE--;
     }
     else
     {
-      puts("error: process not active\n", 26);
+      kputs("error: process not active\n", 26);
     }
     break;
   }
@@ -250,16 +310,16 @@ void hilevel_handler_svc(ctx_t *ctx, uint32_t id)
     if (PROCS < MAX_PROCS)
     {
       void *addr = (void *)(ctx->gpr[0]);
-      //  reset stack of fork,
-      pid_t pid = procExec(addr);
-      dispatch(ctx, NULL, &procTable[procTableContains(pid)]);
+      //  reset stack of fork (the calling process),
+      procExec(currentProc, addr);
+      dispatch(ctx, NULL, currentProc);
 
       //  enableMLFQ();
     }
     else
     {
       //  TODO MMU
-      puts("error: exceeded MAX_PROCS\n", 26);
+      kputs("error: exceeded MAX_PROCS\n", 26);
     }
     break;
   }
@@ -273,20 +333,14 @@ void hilevel_handler_svc(ctx_t *ctx, uint32_t id)
     {
       if (exitStatus == EXIT_SUCCESS)
       {
-        semTableRemove(pid);
-        shmTabRemove(pid);
-        removeFromMLFQ(pid);
-        procDelete(pid);
+        procTeardown(pid);
         schedule(ctx);
       }
       else
       {
         procHistoryInit(&procTable[procTableContains(pid)]);
-        semTableRemove(pid);
-        shmTabRemove(pid);
-        removeFromMLFQ(pid);
-        procDelete(pid);
-        puts("console$ process killed and stored in history table\n", 52);
+        procTeardown(pid);
+        kputs("console$ process killed and stored in history table\n", 52);
         schedule(ctx);
       }
       PROCS_ACTIVE--;
@@ -294,7 +348,7 @@ void hilevel_handler_svc(ctx_t *ctx, uint32_t id)
     }
     else
     {
-      puts("error: process not active\n", 26);
+      kputs("error: process not active\n", 26);
       ctx->gpr[0] = -1;
     }
     break;
@@ -304,7 +358,7 @@ void hilevel_handler_svc(ctx_t *ctx, uint32_t id)
   { // 0x07 => prio( pid, p )
     pid_t pid = (pid_t)(ctx->gpr[0]);
     int p = (int)(ctx->gpr[1]);
-    char *pidString;
+    char pidString[12];
 
     if (procTableContains(pid) > -1)
     {
@@ -315,15 +369,15 @@ void hilevel_handler_svc(ctx_t *ctx, uint32_t id)
       }
       else
       {
-        puts("error: priority must be >= 0\n", 29);
+        kputs("error: priority must be >= 0\n", 29);
       }
     }
     else
     {
-      puts("error: no process with id ", 26);
+      kputs("error: no process with id ", 26);
       itoaLocal(pidString, pid);
-      puts(pidString, strlen(pidString));
-      puts("\n", 1);
+      kputs(pidString, strlen(pidString));
+      kputs("\n", 1);
     }
     break;
   }
@@ -343,12 +397,12 @@ void hilevel_handler_svc(ctx_t *ctx, uint32_t id)
       }
       else
       {
-        puts("error: process not active\n", 26);
+        kputs("error: process not active\n", 26);
       }
     }
     else
     {
-      puts("error: process already paused\n", 30);
+      kputs("error: process already paused\n", 30);
     }
     break;
   }
@@ -366,54 +420,59 @@ void hilevel_handler_svc(ctx_t *ctx, uint32_t id)
     }
     else
     {
-      puts("error: process not paused\n", 26);
+      kputs("error: process not paused\n", 26);
     }
     break;
   }
 
+  case 0x0A:
+  { // 0x0A => sched_handoff( on )
+    currentProc->handoff = (ctx->gpr[0] != 0);
+    break;
+  }
+
   case 0x10:
   { // 0x10 => status()
-    puts("---PROCESS TABLE ENTRIES:---\n", 29);
+    kputs("---PROCESS TABLE ENTRIES:---\n", 29);
     if (PROCS > 1)
     {
-      for (int i = 0; i < PROCS; i++)
+      for (int i = 0; i < procTabSize; i++)
       {
-        if (procTable[i].pid != -1)
+        if (procTable[i].pid != -1 && procTable[i].pid != 0)
         {
           pid_t pid = procTable[i].pid;
           status_t status = procTable[i].status;
           int priority = procTable[i].priority;
-          char *pidString;
-          char *priorityString;
-          char *statusString = malloc(sizeof(char));
-          statusString[0] = statusToString(status);
+          char pidString[12];
+          char priorityString[12];
+          char statusString[2] = {statusToString(status), '\0'};
 
-          puts("---ID: ", 7);
+          kputs("---ID: ", 7);
           itoaLocal(pidString, pid);
-          puts(pidString, strlen(pidString));
-          puts("\n", 1);
-          puts("---PRIORITY: ", 13);
+          kputs(pidString, strlen(pidString));
+          kputs("\n", 1);
+          kputs("---PRIORITY: ", 13);
           itoaLocal(priorityString, priority);
-          puts(priorityString, strlen(priorityString));
-          puts("\n", 1);
-          puts("---STATUS: ", 11);
-          puts(statusString, strlen(statusString));
-          puts("\n", 1);
-          puts("----------------------------\n", 29);
+          kputs(priorityString, strlen(priorityString));
+          kputs("\n", 1);
+          kputs("---STATUS: ", 11);
+          kputs(statusString, strlen(statusString));
+          kputs("\n", 1);
+          kputs("----------------------------\n", 29);
         }
       }
     }
     else
     {
-      puts("---No entries\n", 14);
-      puts("----------------------------\n", 29);
+      kputs("---No entries\n", 14);
+      kputs("----------------------------\n", 29);
     }
     break;
   }
 
   case 0x11:
   { // 0x11 => history()
-    puts("---PROCESS TABLE HISTORY:---\n", 29);
+    kputs("---PROCESS TABLE HISTORY:---\n", 29);
     if (HISTORY_PROCS > 0)
     {
       for (int i = 0; i < HISTORY_PROCS; i++)
@@ -421,29 +480,28 @@ void hilevel_handler_svc(ctx_t *ctx, uint32_t id)
         pid_t pid = procTableHistory[i].pid;
         status_t status = procTableHistory[i].status;
         int priority = procTableHistory[i].priority;
-        char *pidString;
-        char *priorityString;
-        char *statusString = malloc(sizeof(char));
-        statusString[0] = statusToString(status);
+        char pidString[12];
+        char priorityString[12];
+        char statusString[2] = {statusToString(status), '\0'};
         itoaLocal(pidString, pid);
         itoaLocal(priorityString, priority);
 
-        puts("---ID: ", 7);
-        puts(pidString, strlen(pidString));
-        puts("\n", 1);
-        puts("---PRIORITY: ", 13);
-        puts(priorityString, strlen(priorityString));
-        puts("\n", 1);
-        puts("---STATUS: ", 11);
-        puts(statusString, strlen(statusString));
-        puts("\n", 1);
-        puts("----------------------------\n", 29);
+        kputs("---ID: ", 7);
+        kputs(pidString, strlen(pidString));
+        kputs("\n", 1);
+        kputs("---PRIORITY: ", 13);
+        kputs(priorityString, strlen(priorityString));
+        kputs("\n", 1);
+        kputs("---STATUS: ", 11);
+        kputs(statusString, strlen(statusString));
+        kputs("\n", 1);
+        kputs("----------------------------\n", 29);
       }
     }
     else
     {
-      puts("---No entries\n", 14);
-      puts("----------------------------\n", 29);
+      kputs("---No entries\n", 14);
+      kputs("----------------------------\n", 29);
     }
     break;
   }
@@ -452,27 +510,28 @@ void hilevel_handler_svc(ctx_t *ctx, uint32_t id)
   { // 0x12 => close(x)
     int exitStatus = (int)(ctx->gpr[1]);
 
-    for (int i = (PROCS - 1); i < 0; i--)
+    //  every process but the console (slot 0); free slots have PID 0
+    for (int i = (procTabSize - 1); i > 0; i--)
     {
-      semTableRemove(procTable[i].pid);
-      shmTabRemove(procTable[i].pid);
-      removeFromMLFQ(procTable[i].pid);
-      procDelete(procTable[i].pid);
+      if (procTable[i].pid != 0)
+      {
+        procTeardown(procTable[i].pid);
+      }
     }
     for (int j = 0; j < HISTORY_PROCS; j++)
     {
       procHistoryDelete(procTableHistory[j].pid);
     }
-    free(procTable);
-    free(procTableHistory);
+    kfree(procTable);
+    kfree(procTableHistory);
     deleteMLFQ();
     if (exitStatus == EXIT_FAILURE)
     {
-      puts("SYSTEM CRASH\n", 13);
+      kputs("SYSTEM CRASH\n", 13);
     }
     else
     {
-      puts("SYSTEM CLOSED\n", 14);
+      kputs("SYSTEM CLOSED\n", 14);
     }
   }
 
@@ -485,6 +544,12 @@ void hilevel_handler_svc(ctx_t *ctx, uint32_t id)
       if (PROCS < MAX_PROCS)
       {
         pid_t pidChild = procCopy(currentProc, ctx);
+        if (pidChild < 0)
+        {
+          kputs("error: out of memory\n", 21);
+          ctx->gpr[0] = -1;
+          break;
+        }
         currentProc->status = STATUS_READY;
         currentProc->ctx.gpr[0] = pidChild;
         dispatch(ctx, currentProc, &procTable[procTableContains(pidChild)]);
@@ -493,14 +558,14 @@ void hilevel_handler_svc(ctx_t *ctx, uint32_t id)
       else
       {
         //  TODO MMU
-        puts("error: exceeded MAX_PROCS\n", 26);
+        kputs("error: exceeded MAX_PROCS\n", 26);
 
         ctx->gpr[0] = -1;
       }
     }
     else
     {
-      puts("error: invalid PID\n", 19);
+      kputs("error: invalid PID\n", 19);
 
       ctx->gpr[0] = -1;
     }
@@ -515,174 +580,545 @@ void hilevel_handler_svc(ctx_t *ctx, uint32_t id)
     break;
   }
 
+  case 0x15:
+  { // 0x15 => slabs()
+    slabStats();
+    break;
+  }
+
+  case 0x16:
+  { // 0x16 => pages()
+    pageStats();
+    break;
+  }
+
+  case 0x17:
+  { // 0x17 => brk( addr )
+    uint32_t addr = (uint32_t)(ctx->gpr[0]);
+
+    ctx->gpr[0] = userHeapBrk(currentProc, addr);
+    //  the heap (and so TPIDRURO) may have just been created
+    userHeapPublish(currentProc);
+    break;
+  }
+
+  case 0x18:
+  { // 0x18 => sbrk( incr )
+    int incr = (int)(ctx->gpr[0]);
+
+    ctx->gpr[0] = userHeapSbrk(currentProc, incr);
+    userHeapPublish(currentProc);
+    break;
+  }
+
+  case 0x19:
+  { // 0x19 => memstat()
+    kheapStats();
+    break;
+  }
+
+  case 0x1A:
+  { // 0x1A => lockstat( n )
+    semTableStats((int)(ctx->gpr[0]));
+    break;
+  }
+
   //  ----IPC----
   case 0x20:
-  { // 0x20 => shm_init( size )
-    size_t size = (size_t)(ctx->gpr[0]);
-    pid_t owner = currentProc->pid;
-
-    int index = shmTabInit(owner, size);
+  { // 0x20 => shm_open( key, size ), returns a handle (-1 on failure) in r0 and the address in r1
+    int key = (int)(ctx->gpr[0]);
+    size_t size = (size_t)(ctx->gpr[1]);
 
-    puts("console$ shared memory segment initialised\n", 43);
+    shm_t *entry = shmTabOpen(currentProc->pid, key, size);
 
-    ctx->gpr[0] = (uint32_t)shmTable[index].addr;
+    if (entry != NULL)
+    {
+      ctx->gpr[0] = entry->handle;
+      ctx->gpr[1] = (uint32_t)entry->addr;
+    }
+    else
+    {
+      kputs("error: shared memory segment not opened\n", 40);
 
+      ctx->gpr[0] = -1;
+      ctx->gpr[1] = 0;
+    }
     break;
   }
 
   case 0x21:
-  { // 0x21 => shm_destroy( addr, pid )
-    //if pid = owner remove from shmTable, free and return 0. Else return -1
-    void *addr = (void *)(ctx->gpr[0]);
-    pid_t pid = currentProc->pid;
+  { // 0x21 => shm_detach( shm )
+    shm_t *entry = shmTabContains((int)(ctx->gpr[0]));
 
-    int index = shmTabContains(addr);
+    ctx->gpr[0] = (entry == NULL) ? -1 : shmTabDetach(entry, currentProc->pid);
+    break;
+  }
 
-    if (index > -1)
+  case 0x22:
+  { // 0x22 => shm_attach( shm ), returns the address (NULL on failure)
+    shm_t *entry = shmTabContains((int)(ctx->gpr[0]));
+
+    ctx->gpr[0] = (entry == NULL) ? 0 : (uint32_t)shmTabAttach(entry, currentProc->pid);
+    break;
+  }
+
+  case 0x30:
+  { // 0x30 => sem_init( sem ), returns a handle (-1 on failure)
+    sem_t *sem = (sem_t *)(ctx->gpr[0]);
+    semb_t *entry = semTableAdd(currentProc->pid, &sem->value);
+
+    if (entry != NULL)
+    {
+      kputs("console$ semaphore initialised\n", 31);
+    }
+    else
+    {
+      kputs("error: out of memory\n", 21);
+    }
+
+    ctx->gpr[0] = (entry == NULL) ? -1 : entry->handle;
+
+    break;
+  }
+
+  case 0x31:
+  { // 0x31 => sem_destroy( handle )
+    semb_t *entry = semTabContains((int)(ctx->gpr[0]));
+
+    if (entry == NULL)
+    {
+      kputs("error: not a semaphore\n", 23);
+    }
+    else if (*entry->value == 0)
     {
-      if (shmTable[index].owner == pid)
+      if (entry->owner == currentProc->pid)
       {
-        shmTabDelete(addr);
-        free(addr);
+        semTabDelete(entry);
+        kputs("console$ semaphore destoyed\n", 28);
       }
       else
       {
-        puts("error: shared memory belongs to parent process\n", 47);
+        kputs("error: semaphore belongs to parent process\n", 43);
       }
     }
     else
     {
-      puts("error: shared memory segment not found\n", 39);
+      kputs("error: semaphore value not 0\n", 29);
     }
+
     break;
   }
 
-  case 0x22:
-  { // 0x22 => shm_write( addr, data, dataSize )
-    int *addr = (int *)(ctx->gpr[0]);
-    int data = (int)(ctx->gpr[1]);
-    size_t size = (size_t)(ctx->gpr[2]);
+  case 0x32:
+  { // 0x32 => sem_post( handle ), entered from user space only if the value is < 0 (processes waiting)
+    semb_t *entry = semTabContains((int)(ctx->gpr[0]));
 
-    int index = shmTabContains(addr);
+    if (entry == NULL)
+    {
+      kputs("error: not a semaphore\n", 23);
+      break;
+    }
+    //  the longest waiting process takes the post directly
+    semTablePost(entry);
 
-    if (index > -1)
+    break;
+  }
+
+  case 0x33:
+  { // 0x33 => sem_wait( handle )
+    semb_t *entry = semTabContains((int)(ctx->gpr[0]));
+
+    if (entry == NULL)
     {
-      if (size <= shmTable[index].size)
-      {
-        memcpy(addr, &data, size);
-        puts("wrote to shared address ", 24);
-        puts("[", 1);
-        char *addrString;
-        itoaLocal(addrString, (uint32_t)addr);
-        puts(addrString, 8);
-        puts("]\n", 2);
-      }
-      else
-      {
-        puts("error: new data is too big for shared memory segment\n", 53);
-      }
+      kputs("error: not a semaphore\n", 23);
+      ctx->gpr[0] = -1;
+      break;
+    }
+    semTableWaiting(entry);
+    if (*entry->value > 0)
+    {
+      (*entry->value)--;
+      ctx->gpr[0] = 0;
+      break;
+    }
+
+    //  block until a sem_post hands this process the semaphore (sem_wait then returns 0)
+    //    -while processes wait, the value is minus the number waiting
+    (*entry->value)--;
+    if (!waitBlock(ctx, &entry->waiters))
+    {
+      //  nothing else can run: sem_wait is retried
+      (*entry->value)++;
+    }
+    break;
+  }
+
+  case 0x34:
+  { // 0x34 => futex_wait( addr, expected )
+    futexWait(ctx, (uint32_t)(ctx->gpr[0]), (int)(ctx->gpr[1]));
+    break;
+  }
+
+  case 0x35:
+  { // 0x35 => futex_wake( addr, n )
+    ctx->gpr[0] = futexWake((uint32_t)(ctx->gpr[0]), (int)(ctx->gpr[1]));
+    break;
+  }
+
+  case 0x36:
+  { // 0x36 => kmutex_init()
+    mutexb_t *entry = mutexTableAdd(currentProc->pid);
+
+    if (entry == NULL)
+    {
+      kputs("error: out of memory\n", 21);
+    }
+    ctx->gpr[0] = (entry == NULL) ? -1 : entry->handle;
+    break;
+  }
+
+  case 0x37:
+  { // 0x37 => kmutex_destroy( mutex )
+    mutexb_t *entry = mutexTabContains((int)(ctx->gpr[0]));
+
+    if (entry == NULL)
+    {
+      kputs("error: not a mutex\n", 19);
+    }
+    else if (entry->creator != currentProc->pid)
+    {
+      kputs("error: mutex belongs to parent process\n", 39);
     }
     else
     {
-      puts("error: shared memory segment not found\n", 39);
+      mutexTabDelete(entry);
     }
     break;
   }
 
-  case 0x30:
-  { // 0x30 => sem_init()
-    sem_t sem = (int *)malloc(sizeof(int));
-    *sem = 0;
+  case 0x38:
+  { // 0x38 => kmutex_lock( mutex )
+    mutexb_t *entry = mutexTabContains((int)(ctx->gpr[0]));
 
-    semTableAdd(sem, 0, currentProc->pid);
+    if (entry == NULL)
+    {
+      kputs("error: not a mutex\n", 19);
+      ctx->gpr[0] = -1;
+      break;
+    }
+    mutexLock(ctx, entry);
+    break;
+  }
 
-    puts("console$ semaphore initialised\n", 31);
+  case 0x39:
+  { // 0x39 => kmutex_unlock( mutex )
+    mutexb_t *entry = mutexTabContains((int)(ctx->gpr[0]));
 
-    ctx->gpr[0] = (uint32_t)sem;
+    ctx->gpr[0] = (entry == NULL) ? -1 : mutexUnlock(entry, currentProc);
+    break;
+  }
+
+  case 0x3A:
+  { // 0x3A => semop( ops, n )
+    int n = (int)(ctx->gpr[1]);
 
+    if (n <= 0)
+    {
+      ctx->gpr[0] = -1;
+      break;
+    }
+    semTableOp(ctx, (sembuf_t *)(ctx->gpr[0]), n);
     break;
   }
 
-  case 0x31:
-  { // 0x31 => sem_destroy( sem )
-    sem_t sem = (sem_t)(ctx->gpr[0]);
+  case 0x40:
+  { // 0x40 => cond_init()
+    syncb_t *entry = syncTableAdd(SYNC_COND, 0, currentProc->pid);
+
+    ctx->gpr[0] = (entry == NULL) ? -1 : entry->handle;
+    break;
+  }
 
-    int index = semTabContains(sem);
+  case 0x41:
+  { // 0x41 => cond_wait( cond, mutex )
+    syncb_t *entry = syncTabContains((int)(ctx->gpr[0]), SYNC_COND);
 
-    if (*sem == 0)
+    if (entry == NULL)
     {
-      if (semTable[index].owner == currentProc->pid)
-      {
-        semTableRemove(currentProc->pid);
-        puts("console$ semaphore destoyed\n", 28);
-      }
-      else
-      {
-        puts("error: semaphore belongs to parent process\n", 43);
-      }
+      kputs("error: not a condition variable\n", 32);
+      ctx->gpr[0] = -1;
+      break;
+    }
+    syncCondWait(ctx, entry, (mutex_t *)(ctx->gpr[1]));
+    break;
+  }
+
+  case 0x42:
+  case 0x43:
+  { // 0x42 => cond_signal( cond ), 0x43 => cond_broadcast( cond )
+    syncb_t *entry = syncTabContains((int)(ctx->gpr[0]), SYNC_COND);
+
+    ctx->gpr[0] = (entry == NULL) ? -1 : syncCondSignal(entry, id == 0x43);
+    break;
+  }
+
+  case 0x44:
+  { // 0x44 => barrier_init( parties )
+    int parties = (int)(ctx->gpr[0]);
+    syncb_t *entry = (parties > 0) ? syncTableAdd(SYNC_BARRIER, parties, currentProc->pid) : NULL;
+
+    ctx->gpr[0] = (entry == NULL) ? -1 : entry->handle;
+    break;
+  }
+
+  case 0x45:
+  { // 0x45 => barrier_wait( barrier )
+    syncb_t *entry = syncTabContains((int)(ctx->gpr[0]), SYNC_BARRIER);
+
+    if (entry == NULL)
+    {
+      kputs("error: not a barrier\n", 21);
+      ctx->gpr[0] = -1;
+      break;
+    }
+    syncBarrierWait(ctx, entry);
+    break;
+  }
+
+  case 0x46:
+  { // 0x46 => rwlock_init()
+    syncb_t *entry = syncTableAdd(SYNC_RWLOCK, 0, currentProc->pid);
+
+    ctx->gpr[0] = (entry == NULL) ? -1 : entry->handle;
+    break;
+  }
+
+  case 0x47:
+  case 0x48:
+  { // 0x47 => rwlock_rdlock( rwlock ), 0x48 => rwlock_wrlock( rwlock )
+    syncb_t *entry = syncTabContains((int)(ctx->gpr[0]), SYNC_RWLOCK);
+
+    if (entry == NULL)
+    {
+      kputs("error: not a rwlock\n", 20);
+      ctx->gpr[0] = -1;
+    }
+    else if (id == 0x47)
+    {
+      syncReadLock(ctx, entry);
     }
     else
     {
-      puts("error: semaphore value not 0\n", 29);
+      syncWriteLock(ctx, entry);
     }
+    break;
+  }
+
+  case 0x49:
+  { // 0x49 => rwlock_unlock( rwlock )
+    syncb_t *entry = syncTabContains((int)(ctx->gpr[0]), SYNC_RWLOCK);
 
+    ctx->gpr[0] = (entry == NULL) ? -1 : syncUnlock(entry, currentProc);
     break;
   }
 
-  case 0x32:
-  { // 0x32 => sem_post( sem )
-    sem_t sem = (sem_t)(ctx->gpr[0]);
+  case 0x4A:
+  { // 0x4A => cond_destroy/barrier_destroy/rwlock_destroy( x )
+    syncb_t *entry = NULL;
+    switch (handleType((int)(ctx->gpr[0])))
+    {
+    case HANDLE_COND:
+      entry = syncTabContains((int)(ctx->gpr[0]), SYNC_COND);
+      break;
+    case HANDLE_BARRIER:
+      entry = syncTabContains((int)(ctx->gpr[0]), SYNC_BARRIER);
+      break;
+    case HANDLE_RWLOCK:
+      entry = syncTabContains((int)(ctx->gpr[0]), SYNC_RWLOCK);
+      break;
+    default:
+      break;
+    }
 
-    int s = *sem;
-    if (s == *sem)
+    if (entry == NULL)
+    {
+      kputs("error: not a synchronisation object\n", 36);
+    }
+    else if (entry->owner != currentProc->pid)
     {
-      *sem++;
-      semTableNotify(sem);
-      puts("semaphore post ", 15);
-      puts("[", 1);
-      char *string;
-      itoaLocal(string, (uint32_t)sem);
-      puts(string, 8);
-      puts("]\n", 2);
+      kputs("error: object belongs to parent process\n", 40);
     }
     else
     {
-      puts("error: race condition on semaphore\n", 35);
+      syncTabDelete(entry);
+    }
+    break;
+  }
+
+  case 0x50:
+  case 0x51:
+  { // 0x50 => pipe_init( size ), 0x51 => chan_init( msgSize, slots )
+    size_t size = (size_t)(ctx->gpr[0]);
+    size_t msgSize = 0;
+    if (id == 0x51)
+    {
+      msgSize = size;
+      size = msgSize * (size_t)(ctx->gpr[1]);
     }
+    pipeb_t *entry = pipeTableAdd(currentProc->pid, (size == 0 && id == 0x50) ? PIPE_SIZE : size, msgSize);
 
+    ctx->gpr[0] = (entry == NULL) ? -1 : entry->handle;
     break;
   }
 
-  case 0x33:
-  { // 0x33 => sem_wait( sem )
-    sem_t sem = (sem_t)(ctx->gpr[0]);
+  case 0x52:
+  case 0x53:
+  { // 0x52 => ipc_send( pipe, x, n, flags ), 0x53 => ipc_recv( pipe, x, n, flags )
+    pipeb_t *entry = pipeTabContains((int)(ctx->gpr[0]));
+    uint8_t *x = (uint8_t *)(ctx->gpr[1]);
+    size_t n = (size_t)(ctx->gpr[2]);
+    int flags = (int)(ctx->gpr[3]);
 
-    if (*sem > 0)
+    if (entry == NULL)
+    {
+      ctx->gpr[0] = -1;
+    }
+    else if (id == 0x52)
     {
-      *sem--;
+      pipeWrite(ctx, entry, x, n, flags);
+    }
+    else
+    {
+      pipeRead(ctx, entry, x, n, flags);
+    }
+    break;
+  }
 
-      ctx->gpr[0] = *sem;
-      break;
+  case 0x54:
+  { // 0x54 => pipe_destroy( pipe )
+    pipeb_t *entry = pipeTabContains((int)(ctx->gpr[0]));
+
+    if (entry == NULL)
+    {
+      kputs("error: not a pipe\n", 18);
+    }
+    else if (entry->owner != currentProc->pid)
+    {
+      kputs("error: object belongs to parent process\n", 40);
+    }
+    else
+    {
+      pipeTabDelete(entry);
     }
+    break;
+  }
+
+  case 0x58:
+  { // 0x58 => ipc_call( dest, msg ) with the message in r1-r8
+    ipcCall(ctx, (pid_t)(ctx->gpr[0]));
+    break;
+  }
+
+  case 0x59:
+  { // 0x59 => ipc_reply_wait( replyTo, msg ) with the message in r1-r8
+    ipcReplyWait(ctx, (pid_t)(ctx->gpr[0]));
+    break;
+  }
+
+  case 0x5A:
+  { // 0x5A => poll( fds, n, timeout )
+    pollFds(ctx, (pollfd_t *)(ctx->gpr[0]), (int)(ctx->gpr[1]), (int)(ctx->gpr[2]));
+    break;
+  }
+
+  case 0x5B:
+  { // 0x5B => pollset_init()
+    pollb_t *set = pollTableAdd(currentProc->pid);
+
+    ctx->gpr[0] = (set == NULL) ? -1 : set->handle;
+    break;
+  }
 
-    if (*sem < 0)
+  case 0x5C:
+  { // 0x5C => pollset_ctl( set, op, handle, events )
+    pollb_t *set = pollTabContains((int)(ctx->gpr[0]));
+
+    ctx->gpr[0] = (set == NULL) ? -1 : pollCtl(set, (int)(ctx->gpr[1]), (int)(ctx->gpr[2]), (int)(ctx->gpr[3]));
+    break;
+  }
+
+  case 0x5D:
+  { // 0x5D => pollset_wait( set, out, max, timeout )
+    pollb_t *set = pollTabContains((int)(ctx->gpr[0]));
+    int max = (int)(ctx->gpr[2]);
+
+    if (set == NULL || max <= 0)
     {
-      puts("error: semaphore value < 0\n", 27);
       ctx->gpr[0] = -1;
       break;
     }
+    pollWait(ctx, set, (pollfd_t *)(ctx->gpr[1]), max, (int)(ctx->gpr[3]));
+    break;
+  }
+
+  case 0x5E:
+  { // 0x5E => pollset_destroy( set )
+    pollb_t *set = pollTabContains((int)(ctx->gpr[0]));
+
+    if (set == NULL)
+    {
+      kputs("error: not a poll set\n", 22);
+    }
+    else if (set->owner != currentProc->pid)
+    {
+      kputs("error: object belongs to parent process\n", 40);
+    }
+    else
+    {
+      pollTabDelete(set);
+    }
+    break;
+  }
 
-    procTable[procTableContains(currentProc->pid)].status = STATUS_WAITING;
-    semTableAdd(sem, currentProc->pid, semGetOwner(sem));
+  case 0x60:
+  { // 0x60 => fd_open( kind, arg )
+    ctx->gpr[0] = fdOpen(currentProc, (int)(ctx->gpr[0]), (int)(ctx->gpr[1]));
+    break;
+  }
+
+  case 0x61:
+  { // 0x61 => fd_close( fd )
+    ctx->gpr[0] = fdClose(currentProc, (int)(ctx->gpr[0]));
+    break;
+  }
+
+  case 0x62:
+  { // 0x62 => dup2( oldfd, newfd )
+    ctx->gpr[0] = fdDup2(currentProc, (int)(ctx->gpr[0]), (int)(ctx->gpr[1]));
+    break;
+  }
 
-    puts("semaphore wait ", 15);
-    puts("[", 1);
-    char *string;
-    itoaLocal(string, (uint32_t)sem);
-    puts(string, 8);
-    puts("]\n", 2);
+  case 0x63:
+  { // 0x63 => fd_seek( fd, offset )
+    ctx->gpr[0] = fdSeek(currentProc, (int)(ctx->gpr[0]), (size_t)(ctx->gpr[1]));
+    break;
+  }
+
+  case 0x64:
+  { // 0x64 => io_setup( ring )
+    ctx->gpr[0] = ioSetup(currentProc, (io_ring_t *)(ctx->gpr[0]));
+    break;
+  }
+
+  case 0x65:
+  { // 0x65 => io_enter( minComplete )
+    ioEnter(ctx, (int)(ctx->gpr[0]));
+    break;
+  }
 
-    ctx->gpr[0] = 0;
+  case 0x66:
+  { // 0x66 => disk_set_mode( mode )
+    ctx->gpr[0] = fdDiskMode((int)(ctx->gpr[0]));
     break;
   }
 
@@ -691,5 +1127,7 @@ void hilevel_handler_svc(ctx_t *ctx, uint32_t id)
     break;
   }
   }
+  //  hand the rest of the period to a process the call woke (if it should run first)
+  scheduleHandoff(ctx, caller);
   return;
 }
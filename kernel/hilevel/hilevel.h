@@ -41,17 +41,36 @@ typedef struct
   uint32_t cpsr, pc, gpr[13], sp, lr;
 } ctx_t;
 
-typedef struct
+//  descriptors per process
+#define MAX_FDS (8)
+
+typedef struct pcb
 {
   pid_t pid;       // Process IDentifier (PID)
   status_t status; // current status
   uint32_t tos;    // address of Top of Stack (ToS)
+  uint32_t entry;  // entry point (for restarts)
   ctx_t ctx;       // execution context
   int priority;
+  uint32_t heap;   // base of the heap (0 until the first brk/sbrk)
+  uint32_t brk;    // current program break
+  uint32_t tls;    // user read-only thread ID register (TPIDRURO) value
+  struct pcb *waitNext;      // next process in the wait queue this one is blocked on
+  struct wait_queue *waitOn; // wait queue this process is blocked on (NULL if none)
+  uint32_t waitKey;          // what it is waiting for, where a queue is shared (e.g., a futex address)
+  bool waitRestart;          // re-execute the blocking system call when woken (rather than return from it)
+  uint32_t waitDeadline;     // 24 MHz counter value at which a timed wait gives up (0 if untimed)
+  bool handoff;              // switch straight to any process this one wakes (sched_handoff)
+  int inherited;             // priority lent by a process blocked on a mutex this one holds (0 if none)
+  int basePriority;          // priority to return to once nothing is lent
+  struct file *fds[MAX_FDS]; // open descriptors (NULL if free)
 } pcb_t;
 
 extern ctx_t ctx;
 
+//  write n bytes of a kernel report to the console (UART1), in order with what it has written itself
+extern void kputs(char *x, int n);
+
 extern uint32_t tos_user;
 
 #endif
@@ -0,0 +1,464 @@
+#include "./fdTable.h"
+#include "../ipc/pipeTable.h"
+#include "../ipc/shmTable.h"
+#include "disk.h"
+#include "SYS.h"
+
+/*  Descriptors: every process has MAX_FDS slots, each NULL or naming a file_t, and read and
+    write go through the file's ops, so a descriptor can name any object the kernel can move
+    bytes to or from. 0, 1 and 2 start out as UART0 and CONSOLE_FILENO as the console's terminal
+    (UART1); either can be pointed at something else (the null sink, a pipe, ...) with dup2.  */
+slab_cache_t fileCache;
+
+//  the UARTs are never closed, so their files are static and hold a reference of their own
+file_t uartFiles[UART_PORTS];
+
+//  disk geometry, queried when the disk is first opened (0 until then)
+int diskBlockLen = 0;
+int diskBlockNum = 0;
+//  bounce buffers for the partial first and last blocks of a disk request
+uint8_t diskBlock[DISK_BLOCK_MAX];
+uint8_t diskTail[DISK_BLOCK_MAX];
+
+void fileCtor(void *obj)
+{
+    memset(obj, 0, sizeof(file_t));
+}
+
+void uartFileRead(ctx_t *ctx, pcb_t *proc, file_t *file, uint8_t *x, size_t n, int timeout)
+{
+    uartRead(ctx, proc, file->obj, x, n, timeout);
+}
+
+void uartFileWrite(ctx_t *ctx, pcb_t *proc, file_t *file, uint8_t *x, size_t n, int flags)
+{
+    uartWrite(ctx, file->obj, x, n, flags);
+}
+
+int uartFilePoll(file_t *file)
+{
+    uart_t *uart = file->obj;
+    return ((uart->rxReady != 0) ? POLLIN : 0) | ((uart->txCount < UART_TX_SIZE) ? POLLOUT : 0);
+}
+
+void fileNoClose(file_t *file)
+{
+    return;
+}
+
+const file_ops_t uartOps = {&uartFileRead, &uartFileWrite, &uartFilePoll, &fileNoClose};
+
+/*  the pipe is looked up on every operation, since its owner may destroy it while it is open
+      -read blocks as pipeRead would, but gives up after timeout ms (r0 is then 0), keeping the deadline
+       it first blocked with as uartRead does; with timeout 0 it returns IPC_AGAIN if nothing is ready  */
+void pipeFileRead(ctx_t *ctx, pcb_t *proc, file_t *file, uint8_t *x, size_t n, int timeout)
+{
+    pipeb_t *entry = pipeTabContains(file->handle);
+    bool expired = timeout != 0 && proc->waitDeadline != 0 && (int32_t)(SYSCONF->COUNTER_24MHZ - proc->waitDeadline) >= 0;
+
+    if (entry == NULL || timeout > POLL_TIMEOUT_MAX)
+    {
+        if (timeout != 0)
+        {
+            proc->waitDeadline = 0;
+        }
+        ctx->gpr[0] = -1;
+        return;
+    }
+    size_t unit = (entry->msgSize != 0) ? entry->msgSize : 1;
+    bool ready = entry->count >= unit || (n == 0 && entry->msgSize == 0);
+
+    if (ready || timeout == 0 || expired)
+    {
+        if (timeout != 0)
+        {
+            proc->waitDeadline = 0;
+        }
+        if (ready || timeout == 0)
+        {
+            pipeRead(ctx, entry, x, n, IPC_NONBLOCK);
+        }
+        else
+        {
+            ctx->gpr[0] = 0;
+        }
+        return;
+    }
+    if (timeout > 0 && proc->waitDeadline == 0)
+    {
+        proc->waitDeadline = pollDeadline(timeout);
+    }
+    waitBlockRestart(ctx, &entry->readers);
+}
+
+//  a blocking write advances the saved x and n (r1 and r2 in both write and ipc_send) and restarts
+void pipeFileWrite(ctx_t *ctx, pcb_t *proc, file_t *file, uint8_t *x, size_t n, int flags)
+{
+    pipeb_t *entry = pipeTabContains(file->handle);
+    if (entry == NULL)
+    {
+        ctx->gpr[0] = -1;
+        return;
+    }
+    pipeWrite(ctx, entry, x, n, flags);
+}
+
+int pipeFilePoll(file_t *file)
+{
+    pipeb_t *entry = pipeTabContains(file->handle);
+    if (entry == NULL)
+    {
+        return POLLERR;
+    }
+    size_t unit = (entry->msgSize != 0) ? entry->msgSize : 1;
+    return ((entry->count >= unit) ? POLLIN : 0) | ((entry->size - entry->count >= unit) ? POLLOUT : 0);
+}
+
+const file_ops_t pipeOps = {&pipeFileRead, &pipeFileWrite, &pipeFilePoll, &fileNoClose};
+
+//  the bytes of the segment from the file's offset that n allows (0 once the end is reached)
+size_t shmFileSpan(shm_t *entry, file_t *file, size_t n)
+{
+    size_t left = (file->offset < entry->size) ? entry->size - file->offset : 0;
+    return (n < left) ? n : left;
+}
+
+void shmFileRead(ctx_t *ctx, pcb_t *proc, file_t *file, uint8_t *x, size_t n, int timeout)
+{
+    shm_t *entry = shmTabContains(file->handle);
+    if (entry == NULL)
+    {
+        ctx->gpr[0] = -1;
+        return;
+    }
+    size_t moved = shmFileSpan(entry, file, n);
+    memcpy(x, (uint8_t *)entry->addr + file->offset, moved);
+    file->offset += moved;
+    ctx->gpr[0] = moved;
+}
+
+void shmFileWrite(ctx_t *ctx, pcb_t *proc, file_t *file, uint8_t *x, size_t n, int flags)
+{
+    shm_t *entry = shmTabContains(file->handle);
+    if (entry == NULL)
+    {
+        ctx->gpr[0] = -1;
+        return;
+    }
+    size_t moved = shmFileSpan(entry, file, n);
+    memcpy((uint8_t *)entry->addr + file->offset, x, moved);
+    file->offset += moved;
+    ctx->gpr[0] = moved;
+}
+
+int shmFilePoll(file_t *file)
+{
+    return (shmTabContains(file->handle) == NULL) ? POLLERR : (POLLIN | POLLOUT);
+}
+
+const file_ops_t shmOps = {&shmFileRead, &shmFileWrite, &shmFilePoll, &fileNoClose};
+
+/*  move up to n bytes between x and the disk from the file's offset, up to DISK_VEC_MAX bytes of
+    contiguous blocks per disk request: whole blocks are scattered into (gathered from) x itself,
+    while a partial first or last block goes through diskBlock or diskTail (and is read before it
+    is written); the disk is driven by polling UART2, so P_{current} (and every interrupt) waits
+    until the transfer is done
+      -r0 is set to the bytes moved, or -1 if the first request failed  */
+void diskFileMove(ctx_t *ctx, file_t *file, uint8_t *x, size_t n, bool write)
+{
+    size_t moved = 0;
+    bool failed = false;
+
+    while (moved < n && !failed)
+    {
+        size_t len = (size_t)diskBlockLen;
+        uint32_t block = file->handle + file->offset / len;
+        size_t within = file->offset % len;
+
+        if (block >= (uint32_t)diskBlockNum)
+        {
+            break;
+        }
+        //  bytes from the start of the first block, capped by the request size and the end of the disk
+        size_t span = within + (n - moved);
+        size_t most = (DISK_VEC_MAX / len < diskBlockNum - block) ? DISK_VEC_MAX / len : diskBlockNum - block;
+        span = (span < most * len) ? span : most * len;
+
+        size_t chunk = span - within;
+        size_t head = (within != 0) ? ((len - within < chunk) ? len - within : chunk) : 0;
+        size_t whole = (chunk - head) / len * len;
+        size_t tail = chunk - head - whole;
+        uint32_t tailBlock = block + (head != 0) + whole / len;
+        disk_iov_t iov[3];
+        int count = 0;
+
+        if (head != 0)
+        {
+            iov[count++] = (disk_iov_t){diskBlock, diskBlockLen};
+        }
+        if (whole != 0)
+        {
+            iov[count++] = (disk_iov_t){x + moved + head, (int)whole};
+        }
+        if (tail != 0)
+        {
+            iov[count++] = (disk_iov_t){diskTail, diskBlockLen};
+        }
+
+        if (write)
+        {
+            failed = (head != 0 && disk_rd(block, diskBlock, diskBlockLen) != DISK_SUCCESS) ||
+                     (tail != 0 && disk_rd(tailBlock, diskTail, diskBlockLen) != DISK_SUCCESS);
+            if (!failed)
+            {
+                memcpy(diskBlock + within, x + moved, head);
+                memcpy(diskTail, x + moved + head + whole, tail);
+                failed = disk_wrv(block, iov, count) != DISK_SUCCESS;
+            }
+        }
+        else
+        {
+            failed = disk_rdv(block, iov, count) != DISK_SUCCESS;
+            if (!failed)
+            {
+                memcpy(x + moved, diskBlock + within, head);
+                memcpy(x + moved + head + whole, diskTail, tail);
+            }
+        }
+        if (!failed)
+        {
+            moved += chunk;
+            file->offset += chunk;
+        }
+    }
+    ctx->gpr[0] = (moved == 0 && failed) ? (uint32_t)-1 : moved;
+}
+
+void diskFileRead(ctx_t *ctx, pcb_t *proc, file_t *file, uint8_t *x, size_t n, int timeout)
+{
+    diskFileMove(ctx, file, x, n, false);
+}
+
+void diskFileWrite(ctx_t *ctx, pcb_t *proc, file_t *file, uint8_t *x, size_t n, int flags)
+{
+    diskFileMove(ctx, file, x, n, true);
+}
+
+int diskFilePoll(file_t *file)
+{
+    return POLLIN | POLLOUT;
+}
+
+const file_ops_t diskOps = {&diskFileRead, &diskFileWrite, &diskFilePoll, &fileNoClose};
+
+void nullFileRead(ctx_t *ctx, pcb_t *proc, file_t *file, uint8_t *x, size_t n, int timeout)
+{
+    ctx->gpr[0] = 0;
+}
+
+void nullFileWrite(ctx_t *ctx, pcb_t *proc, file_t *file, uint8_t *x, size_t n, int flags)
+{
+    ctx->gpr[0] = n;
+}
+
+int nullFilePoll(file_t *file)
+{
+    return POLLIN | POLLOUT;
+}
+
+const file_ops_t nullOps = {&nullFileRead, &nullFileWrite, &nullFilePoll, &fileNoClose};
+
+//  creates the file cache and the UARTs' files
+void fdTableInit()
+{
+    slabCacheInit(&fileCache, "file", sizeof(file_t), sizeof(void *), &fileCtor);
+    for (int i = 0; i < UART_PORTS; i++)
+    {
+        uartFiles[i].ops = &uartOps;
+        uartFiles[i].kind = FILE_UART;
+        uartFiles[i].obj = &uartTable[i];
+        uartFiles[i].refs = 1;
+    }
+    return;
+}
+
+//  give a new process the standard descriptors: 0, 1 and 2 on UART0, CONSOLE_FILENO on UART1
+void fdStd(pcb_t *proc)
+{
+    memset(proc->fds, 0, sizeof(proc->fds));
+    for (int fd = 0; fd <= CONSOLE_FILENO; fd++)
+    {
+        proc->fds[fd] = &uartFiles[(fd == CONSOLE_FILENO) ? 1 : 0];
+        proc->fds[fd]->refs++;
+    }
+    return;
+}
+
+//  a fork's descriptors (copied with its PCB) name the same files as its parent's
+void fdFork(pcb_t *child)
+{
+    for (int fd = 0; fd < MAX_FDS; fd++)
+    {
+        if (child->fds[fd] != NULL)
+        {
+            child->fds[fd]->refs++;
+        }
+    }
+    return;
+}
+
+//  returns the file fd names in proc (NULL if none)
+file_t *fdLookup(pcb_t *proc, int fd)
+{
+    return (fd >= 0 && fd < MAX_FDS) ? proc->fds[fd] : NULL;
+}
+
+//  drop one reference to file, closing it with the last
+void fdRelease(file_t *file)
+{
+    if (--file->refs == 0)
+    {
+        file->ops->close(file);
+        fileCtor(file);
+        slabFree(&fileCache, file);
+    }
+    return;
+}
+
+/*  open a file on an object of the given kind (arg: the UART number, pipe or channel handle, segment
+    handle or first disk block), returning the lowest free descriptor or -1 on error  */
+int fdOpen(pcb_t *proc, int kind, int arg)
+{
+    int fd = 0;
+    while (fd < MAX_FDS && proc->fds[fd] != NULL)
+    {
+        fd++;
+    }
+    if (fd == MAX_FDS)
+    {
+        return -1;
+    }
+    if (kind == FILE_UART)
+    {
+        if (arg < 0 || arg >= UART_PORTS)
+        {
+            return -1;
+        }
+        proc->fds[fd] = &uartFiles[arg];
+        proc->fds[fd]->refs++;
+        return fd;
+    }
+
+    const file_ops_t *ops;
+    switch (kind)
+    {
+    case FILE_PIPE:
+        ops = (pipeTabContains(arg) != NULL) ? &pipeOps : NULL;
+        break;
+    case FILE_SHM:
+        ops = (shmTabContains(arg) != NULL) ? &shmOps : NULL;
+        break;
+    case FILE_DISK:
+        if (diskBlockLen == 0)
+        {
+            //  binary frames if the disk speaks them, else the original hex lines
+            disk_conf(DISK_MODE_BIN);
+            int len = disk_get_block_len();
+            int num = disk_get_block_num();
+            if (len > 0 && len <= DISK_BLOCK_MAX && num > 0)
+            {
+                diskBlockLen = len;
+                diskBlockNum = num;
+            }
+        }
+        ops = (diskBlockLen != 0 && arg >= 0 && arg < diskBlockNum) ? &diskOps : NULL;
+        break;
+    case FILE_NULL:
+        ops = &nullOps;
+        break;
+    default:
+        ops = NULL;
+        break;
+    }
+    if (ops == NULL)
+    {
+        return -1;
+    }
+    file_t *file = slabAlloc(&fileCache);
+    if (file == NULL)
+    {
+        return -1;
+    }
+    file->ops = ops;
+    file->kind = kind;
+    file->handle = arg;
+    file->refs = 1;
+    proc->fds[fd] = file;
+    return fd;
+}
+
+//  close descriptor fd of proc, returning 0 (-1 if it names nothing)
+int fdClose(pcb_t *proc, int fd)
+{
+    file_t *file = fdLookup(proc, fd);
+    if (file == NULL)
+    {
+        return -1;
+    }
+    proc->fds[fd] = NULL;
+    fdRelease(file);
+    return 0;
+}
+
+//  make newFd of proc name the file oldFd does (closing what it named), returning newFd (-1 on error)
+int fdDup2(pcb_t *proc, int oldFd, int newFd)
+{
+    file_t *file = fdLookup(proc, oldFd);
+    if (file == NULL || newFd < 0 || newFd >= MAX_FDS)
+    {
+        return -1;
+    }
+    if (newFd != oldFd)
+    {
+        file->refs++;
+        if (proc->fds[newFd] != NULL)
+        {
+            fdRelease(proc->fds[newFd]);
+        }
+        proc->fds[newFd] = file;
+    }
+    return newFd;
+}
+
+//  move the offset of the file fd names in proc (a segment or the disk), returning 0 (-1 on error)
+int fdSeek(pcb_t *proc, int fd, size_t offset)
+{
+    file_t *file = fdLookup(proc, fd);
+    if (file == NULL || (file->kind != FILE_SHM && file->kind != FILE_DISK))
+    {
+        return -1;
+    }
+    file->offset = offset;
+    return 0;
+}
+
+//  switch the disk to protocol mode (DISK_MODE_HEX or DISK_MODE_BIN), returning the mode now in use
+int fdDiskMode(int mode)
+{
+    return disk_conf(mode);
+}
+
+//  for the process with the given PID: close every descriptor
+void fdTableRemove(pid_t pid)
+{
+    int slot = procTableContains(pid);
+    if (slot < 0)
+    {
+        return;
+    }
+    for (int fd = 0; fd < MAX_FDS; fd++)
+    {
+        fdClose(&procTable[slot], fd);
+    }
+    return;
+}
@@ -0,0 +1,52 @@
+#ifndef __FDTABLE_H
+#define __FDTABLE_H
+
+#include "../hilevel/hilevel.h"
+#include "../../user/libc.h"
+#include "../processTables/processTable.h"
+#include "../memory/slab.h"
+#include "./uart.h"
+
+//  largest disk block the disk device buffers (the disk reports its own length)
+#define DISK_BLOCK_MAX (512)
+
+struct file;
+
+/*  what a descriptor does with each operation on behalf of proc; read and write set r0 (bytes moved,
+    0 at the end of a file or on timeout, -1 on error) and may block proc (then P_{current}) as the
+    object's own system calls would, unless read has timeout 0 or write has IPC_NONBLOCK (r0 is then
+    IPC_AGAIN if nothing could move); poll returns the POLLIN/POLLOUT ready now  */
+typedef struct file_ops
+{
+    void (*read)(ctx_t *ctx, pcb_t *proc, struct file *file, uint8_t *x, size_t n, int timeout);
+    void (*write)(ctx_t *ctx, pcb_t *proc, struct file *file, uint8_t *x, size_t n, int flags);
+    int (*poll)(struct file *file);
+    void (*close)(struct file *file);
+} file_ops_t;
+
+/*  an open object, shared by every descriptor naming it (dup2, and a fork's copies of the
+    parent's) and closed when the last is  */
+typedef struct file
+{
+    const file_ops_t *ops;
+    int kind;      // FILE_UART, FILE_PIPE, ...
+    void *obj;     // the UART (FILE_UART)
+    int handle;    // the pipe or segment (FILE_PIPE, FILE_SHM), or first block (FILE_DISK)
+    size_t offset; // position of the next read or write (FILE_SHM, FILE_DISK)
+    int refs;
+} file_t;
+
+extern slab_cache_t fileCache;
+
+extern void fdTableInit();
+extern void fdStd(pcb_t *proc);
+extern void fdFork(pcb_t *child);
+extern file_t *fdLookup(pcb_t *proc, int fd);
+extern int fdOpen(pcb_t *proc, int kind, int arg);
+extern int fdClose(pcb_t *proc, int fd);
+extern int fdDup2(pcb_t *proc, int oldFd, int newFd);
+extern int fdSeek(pcb_t *proc, int fd, size_t offset);
+extern int fdDiskMode(int mode);
+extern void fdTableRemove(pid_t pid);
+
+#endif
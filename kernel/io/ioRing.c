@@ -0,0 +1,227 @@
+#include "./ioRing.h"
+
+/*  Asynchronous I/O rings: a process registers an io_ring_t in its own memory (there is no MMU,
+    so the kernel reads and writes it in place). Submissions are taken into the process's pending
+    list on io_enter, or on the timer tick for IORING_SQPOLL rings, and every pending operation is
+    attempted without blocking through its descriptor's ops: one that isn't ready (poll says so, or
+    the write returns IPC_AGAIN) stays pending and is tried again whenever a UART interrupts, a
+    pollable object changes (pollNotify) or the timer ticks. Disk operations are the exception:
+    the disk is driven by polling UART2 for the whole transfer, so they only run in io_enter, for
+    the process entering it, never from an interrupt. A submission is only taken while the
+    completion queue has room for everything in flight, so completions never overflow.  */
+io_ctx_t *ioTable = NULL;
+
+//  set while rings are being run, so an object changing under an operation doesn't run them again
+bool ioBusy = false;
+bool ioAgain = false;
+
+void ioTableInit()
+{
+    ioTable = kcalloc(MAX_PROCS, sizeof(io_ctx_t));
+    return;
+}
+
+/*  register ring for proc (NULL unregisters), dropping anything in flight; returns 0, or -1 if
+    entries isn't a power of two or a queue is missing  */
+int ioSetup(pcb_t *proc, io_ring_t *ring)
+{
+    io_ctx_t *io = &ioTable[proc - procTable];
+
+    if (ring != NULL && (ring->entries == 0 || (ring->entries & (ring->entries - 1)) != 0 || ring->sq == NULL || ring->cq == NULL))
+    {
+        return -1;
+    }
+    io->ring = ring;
+    io->length = 0;
+    return 0;
+}
+
+/*  try to finish operation p of proc without blocking, setting *res to its result; entered is set
+    only in io_enter for proc itself, the one place a disk operation may run
+      -returns false if its descriptor isn't ready (a write keeps what it has moved in p->done)  */
+bool ioAttempt(pcb_t *proc, io_pending_t *p, int *res, bool entered)
+{
+    ctx_t scratch;
+    file_t *file = fdLookup(proc, p->sqe.fd);
+
+    if (p->sqe.op == IORING_OP_NOP)
+    {
+        *res = 0;
+        return true;
+    }
+    if (file == NULL || (p->sqe.op != IORING_OP_READ && p->sqe.op != IORING_OP_WRITE))
+    {
+        *res = -1;
+        return true;
+    }
+    if (file->kind == FILE_DISK && !entered)
+    {
+        return false;
+    }
+
+    int ready = file->ops->poll(file);
+    if (p->sqe.op == IORING_OP_READ)
+    {
+        if (!(ready & (POLLIN | POLLERR)))
+        {
+            return false;
+        }
+        file->ops->read(&scratch, proc, file, p->sqe.buf, p->sqe.len, 0);
+        *res = (int)scratch.gpr[0];
+        return *res != IPC_AGAIN;
+    }
+
+    if (!(ready & (POLLOUT | POLLERR)))
+    {
+        return false;
+    }
+    file->ops->write(&scratch, proc, file, (uint8_t *)p->sqe.buf + p->done, p->sqe.len - p->done, IPC_NONBLOCK);
+    int r = (int)scratch.gpr[0];
+    if (r == IPC_AGAIN)
+    {
+        return false;
+    }
+    if (r < 0)
+    {
+        *res = (p->done != 0) ? (int)p->done : r;
+        return true;
+    }
+    p->done += r;
+    //  nothing moved although ready: the end of a segment or the disk
+    *res = p->done;
+    return r == 0 || p->done >= p->sqe.len;
+}
+
+/*  run the ring of the process in slot: take new submissions if take is set, attempt everything
+    pending (once an operation on a descriptor can't finish, later ones on it wait their turn; disk
+    operations only if entered), post completions, and wake the process if it is waiting for as many
+    as are now unreaped  */
+void ioRun(int slot, bool take, bool entered)
+{
+    io_ctx_t *io = &ioTable[slot];
+    io_ring_t *ring = io->ring;
+    uint32_t mask = ring->entries - 1;
+
+    while (take && io->length < IORING_PENDING && ring->sqHead != ring->sqTail &&
+           (ring->cqTail - ring->cqHead) + io->length < ring->entries)
+    {
+        io->pending[io->length].sqe = ring->sq[ring->sqHead & mask];
+        io->pending[io->length].done = 0;
+        io->length++;
+        ring->sqHead++;
+    }
+
+    uint32_t stalled = 0;
+    int kept = 0;
+    for (int i = 0; i < io->length; i++)
+    {
+        io_pending_t *p = &io->pending[i];
+        uint32_t fdBit = (p->sqe.fd >= 0 && p->sqe.fd < MAX_FDS) ? 1u << p->sqe.fd : 0;
+        int res;
+
+        if (!(stalled & fdBit) && ioAttempt(&procTable[slot], p, &res, entered))
+        {
+            io_cqe_t *cqe = &ring->cq[ring->cqTail & mask];
+            cqe->userData = p->sqe.userData;
+            cqe->res = res;
+            ring->cqTail++;
+            continue;
+        }
+        stalled |= fdBit;
+        if (kept != i)
+        {
+            io->pending[kept] = *p;
+        }
+        kept++;
+    }
+    io->length = kept;
+
+    pcb_t *waiter = io->waiter.head;
+    if (waiter != NULL && ring->cqTail - ring->cqHead >= waiter->waitKey)
+    {
+        waitWake(&io->waiter, 0);
+    }
+    return;
+}
+
+/*  run every registered ring, taking the submissions of the ring in slot take (-1 for none; it is
+    being entered, so its disk operations run too) and, on a tick, of every IORING_SQPOLL ring; runs
+    again while operations changed objects under it  */
+void ioRunAll(int take, bool tick)
+{
+    if (ioBusy)
+    {
+        ioAgain = true;
+        return;
+    }
+    ioBusy = true;
+    do
+    {
+        ioAgain = false;
+        for (int i = 0; i < MAX_PROCS; i++)
+        {
+            if (ioTable[i].ring != NULL)
+            {
+                ioRun(i, i == take || (tick && (ioTable[i].ring->flags & IORING_SQPOLL)), i == take);
+            }
+        }
+        take = -1;
+        tick = false;
+    } while (ioAgain);
+    ioBusy = false;
+    return;
+}
+
+/*  io_enter for P_{current}: take its submissions and run its ring, then block until at least
+    minComplete completions are unreaped (if fewer are, and operations are in flight that could
+    add to them); r0 is set to the number unreaped, or -1 if no ring is registered  */
+void ioEnter(ctx_t *ctx, int minComplete)
+{
+    int slot = currentProc - procTable;
+    io_ctx_t *io = &ioTable[slot];
+
+    if (io->ring == NULL)
+    {
+        ctx->gpr[0] = -1;
+        return;
+    }
+    ioRunAll(slot, false);
+
+    uint32_t ready = io->ring->cqTail - io->ring->cqHead;
+    if (minComplete <= 0 || ready >= (uint32_t)minComplete || io->length == 0)
+    {
+        ctx->gpr[0] = ready;
+        return;
+    }
+    currentProc->waitKey = minComplete;
+    waitBlockRestart(ctx, &io->waiter);
+    return;
+}
+
+//  an object has changed: retry the pending operations of every ring
+void ioPoll()
+{
+    ioRunAll(-1, false);
+    return;
+}
+
+//  on the timer interrupt: take the submissions of IORING_SQPOLL rings and retry everything pending
+void ioTick()
+{
+    ioRunAll(-1, true);
+    return;
+}
+
+//  for the process with the given PID: unregister its ring, dropping anything in flight
+void ioTableRemove(pid_t pid)
+{
+    int slot = procTableContains(pid);
+    if (slot < 0)
+    {
+        return;
+    }
+    waitQueueRemove(&ioTable[slot].waiter, &procTable[slot]);
+    ioTable[slot].ring = NULL;
+    ioTable[slot].length = 0;
+    return;
+}
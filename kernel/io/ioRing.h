@@ -0,0 +1,41 @@
+#ifndef __IORING_H
+#define __IORING_H
+
+#include "../hilevel/hilevel.h"
+#include "../../user/libc.h"
+#include "../processTables/processTable.h"
+#include "../memory/kheap.h"
+#include "../ipc/waitQueue.h"
+#include "./fdTable.h"
+
+//  operations a process can have taken from its ring and not yet completed
+#define IORING_PENDING (16)
+
+//  a taken operation, with the bytes a write has moved so far
+typedef struct
+{
+    io_sqe_t sqe;
+    uint32_t done;
+} io_pending_t;
+
+/*  the asynchronous I/O state of one process, indexed by process table slot
+      -pending: operations in flight, in submission order
+      -waiter: the process itself, while blocked in io_enter (waitKey = completions wanted)  */
+typedef struct
+{
+    io_ring_t *ring; // NULL if none is registered
+    io_pending_t pending[IORING_PENDING];
+    int length;
+    wait_queue_t waiter;
+} io_ctx_t;
+
+extern io_ctx_t *ioTable;
+
+extern void ioTableInit();
+extern int ioSetup(pcb_t *proc, io_ring_t *ring);
+extern void ioEnter(ctx_t *ctx, int minComplete);
+extern void ioPoll();
+extern void ioTick();
+extern void ioTableRemove(pid_t pid);
+
+#endif
@@ -0,0 +1,233 @@
+#include "./uart.h"
+#include "SYS.h"
+
+uart_t uartTable[UART_PORTS];
+
+/*  clear every interrupt of both UARTs and unmask receive (FIFO level and timeout, so a lone byte
+    is not left in the FIFO); TX interrupts are unmasked only while output is buffered
+      -UART1 is the console's terminal, so its input is handed out a line at a time  */
+void uartInit()
+{
+    memset(uartTable, 0, sizeof(uartTable));
+    uartTable[0].dev = UART0;
+    uartTable[1].dev = UART1;
+    uartTable[1].lines = true;
+
+    for (int i = 0; i < UART_PORTS; i++)
+    {
+        uartTable[i].dev->IMSC = UART_INT_RX | UART_INT_RT;
+        uartTable[i].dev->ICR = 0x000007FF;
+        uartTable[i].dev->CR = 0x00000301; // enable UART (Tx+Rx)
+    }
+    return;
+}
+
+/*  move buffered output into the transmit FIFO until one or the other runs out, then leave
+    the TX interrupt unmasked only if output is still waiting  */
+void uartKick(uart_t *uart)
+{
+    while (uart->txCount != 0 && !(uart->dev->FR & UART_FR_TXFF))
+    {
+        uart->dev->DR = uart->tx[uart->txHead];
+        uart->txHead = (uart->txHead + 1) & (UART_TX_SIZE - 1);
+        uart->txCount--;
+    }
+    if (uart->txCount != 0)
+    {
+        uart->dev->IMSC |= UART_INT_TX;
+    }
+    else
+    {
+        uart->dev->IMSC &= ~UART_INT_TX;
+    }
+    return;
+}
+
+//  copy n bytes from x into the ring (there must be room), wrapping at most once
+void uartCopyIn(uart_t *uart, uint8_t *x, size_t n)
+{
+    size_t tail = (uart->txHead + uart->txCount) & (UART_TX_SIZE - 1);
+    size_t first = (n < UART_TX_SIZE - tail) ? n : UART_TX_SIZE - tail;
+
+    memcpy(uart->tx + tail, x, first);
+    memcpy(uart->tx, x + first, n - first);
+    uart->txCount += n;
+}
+
+/*  write for P_{current}: buffer as much of x as fits and return; if the ring fills, the
+    saved x and n are advanced and P_{current} blocks until the TX interrupt makes room, when
+    the call restarts with what is left (r0 ends up as the bytes moved by the last step)
+      -with IPC_NONBLOCK, r0 is set to what fitted (IPC_AGAIN if nothing did) instead  */
+void uartWrite(ctx_t *ctx, uart_t *uart, uint8_t *x, size_t n, int flags)
+{
+    size_t room = UART_TX_SIZE - uart->txCount;
+    size_t moved = (n < room) ? n : room;
+
+    uartCopyIn(uart, x, moved);
+    uartKick(uart);
+
+    if (moved == n || (flags & IPC_NONBLOCK))
+    {
+        ctx->gpr[0] = (moved == 0 && n != 0) ? IPC_AGAIN : moved;
+        return;
+    }
+    ctx->gpr[1] = (uint32_t)(x + moved);
+    ctx->gpr[2] = n - moved;
+    waitBlockRestart(ctx, &uart->writers);
+    return;
+}
+
+/*  read for proc: copy up to n buffered bytes (at most one line, on a line-buffered UART) to x,
+    setting r0 to how many; while nothing is ready, block until input arrives or timeout ms pass
+    (< 0 for ever, 0 not at all, over POLL_TIMEOUT_MAX an error: r0 is -1), when r0 is 0; a restarted
+    read keeps the deadline it first blocked with
+      -only a read that may block (proc is P_{current}) uses proc's deadline, so one with timeout 0 can
+       run for any process (an I/O ring's, from an interrupt) without disturbing its waits  */
+void uartRead(ctx_t *ctx, pcb_t *proc, uart_t *uart, uint8_t *x, size_t n, int timeout)
+{
+    bool expired = timeout != 0 && proc->waitDeadline != 0 && (int32_t)(SYSCONF->COUNTER_24MHZ - proc->waitDeadline) >= 0;
+
+    if (timeout > POLL_TIMEOUT_MAX)
+    {
+        ctx->gpr[0] = -1;
+        return;
+    }
+    if (uart->rxReady != 0 || n == 0 || timeout == 0 || expired)
+    {
+        size_t moved = (n < uart->rxReady) ? n : uart->rxReady;
+        for (size_t i = 0; uart->lines && i < moved; i++)
+        {
+            if (uart->rx[(uart->rxHead + i) & (UART_RX_SIZE - 1)] == '\n')
+            {
+                moved = i + 1;
+            }
+        }
+        size_t first = (moved < UART_RX_SIZE - uart->rxHead) ? moved : UART_RX_SIZE - uart->rxHead;
+
+        memcpy(x, uart->rx + uart->rxHead, first);
+        memcpy(x + first, uart->rx, moved - first);
+        uart->rxHead = (uart->rxHead + moved) & (UART_RX_SIZE - 1);
+        uart->rxCount -= moved;
+        uart->rxReady -= moved;
+        //  pass the wake on to the next reader while input is left
+        if (uart->rxReady != 0)
+        {
+            waitWake(&uart->readers, 0);
+        }
+        if (timeout != 0)
+        {
+            proc->waitDeadline = 0;
+        }
+        ctx->gpr[0] = moved;
+        return;
+    }
+    if (timeout > 0 && proc->waitDeadline == 0)
+    {
+        proc->waitDeadline = pollDeadline(timeout);
+    }
+    waitBlockRestart(ctx, &uart->readers);
+    return;
+}
+
+//  buffer one byte of kernel output, dropping it if the ring is full (never blocks)
+void uartPutc(uart_t *uart, uint8_t x)
+{
+    if (uart->txCount < UART_TX_SIZE)
+    {
+        uartCopyIn(uart, &x, 1);
+        uartKick(uart);
+    }
+    return;
+}
+
+/*  kernel reports (from SVC mode, where write can't be used) are queued on UART1 behind whatever the
+    console has buffered, so the two appear in order; a full ring is drained by spinning on the FIFO
+      -before uartInit there is no ring, so the bytes go straight to the FIFO  */
+void kputs(char *x, int n)
+{
+    uart_t *uart = &uartTable[1];
+
+    for (int i = 0; i < n; i++)
+    {
+        if (uart->dev == NULL)
+        {
+            PL011_putc(UART1, x[i], true);
+            continue;
+        }
+        while (uart->txCount == UART_TX_SIZE)
+        {
+            uartKick(uart);
+        }
+        uartCopyIn(uart, (uint8_t *)&x[i], 1);
+    }
+    if (uart->dev != NULL)
+    {
+        uartKick(uart);
+    }
+    return;
+}
+
+/*  interrupt handler: empty the receive FIFO into the input ring and wake a reader once input is
+    ready (on a line-buffered UART, when a newline arrives or the ring fills), then refill
+    the transmit FIFO and wake the writers once there is room  */
+void uartIrq(uart_t *uart)
+{
+    if (uart->dev->MIS & (UART_INT_RX | UART_INT_RT))
+    {
+        uart->dev->ICR = UART_INT_RX | UART_INT_RT;
+        while (!(uart->dev->FR & UART_FR_RXFE))
+        {
+            uint8_t x = uart->dev->DR;
+            if (uart->rxCount < UART_RX_SIZE)
+            {
+                uart->rx[(uart->rxHead + uart->rxCount) & (UART_RX_SIZE - 1)] = x;
+                uart->rxCount++;
+            }
+            if (!uart->lines || x == '\n' || uart->rxCount == UART_RX_SIZE)
+            {
+                uart->rxReady = uart->rxCount;
+            }
+        }
+        if (uart->rxReady != 0)
+        {
+            waitWake(&uart->readers, 0);
+        }
+    }
+    if (uart->dev->MIS & UART_INT_TX)
+    {
+        uart->dev->ICR = UART_INT_TX;
+        uartKick(uart);
+        if (uart->txCount < UART_TX_SIZE)
+        {
+            waitWakeAll(&uart->writers, 0);
+        }
+    }
+    return;
+}
+
+//  on the timer interrupt: end every read whose deadline has passed, returning 0
+void uartTimers()
+{
+    uint32_t now = SYSCONF->COUNTER_24MHZ;
+    for (int i = 0; i < UART_PORTS; i++)
+    {
+        waitExpire(&uartTable[i].readers, now);
+    }
+    return;
+}
+
+//  for the process with the given PID: stop waiting on any UART
+void uartTableRemove(pid_t pid)
+{
+    int slot = procTableContains(pid);
+    if (slot < 0)
+    {
+        return;
+    }
+    for (int i = 0; i < UART_PORTS; i++)
+    {
+        waitQueueRemove(&uartTable[i].writers, &procTable[slot]);
+        waitQueueRemove(&uartTable[i].readers, &procTable[slot]);
+    }
+    return;
+}
@@ -0,0 +1,56 @@
+#ifndef __UART_H
+#define __UART_H
+
+#include "../hilevel/hilevel.h"
+#include "../../user/libc.h"
+#include "../processTables/processTable.h"
+#include "../ipc/waitQueue.h"
+#include "../ipc/pollTable.h"
+
+//  UARTs driven by the kernel: UART0 (standard output, kernel traces) and UART1 (console)
+#define UART_PORTS (2)
+//  bytes of output buffered per UART (a power of two)
+#define UART_TX_SIZE (0x400)
+//  bytes of input buffered per UART (a power of two); more arriving while it is full are dropped
+#define UART_RX_SIZE (0x100)
+
+//  PL011 interrupt bits (IMSC, MIS and ICR)
+#define UART_INT_RX (0x010)
+#define UART_INT_TX (0x020)
+#define UART_INT_RT (0x040)
+//  PL011 flags (FR)
+#define UART_FR_RXFE (0x010)
+#define UART_FR_TXFF (0x020)
+
+/*  rings of one UART
+      -output: write() copies into it and returns, the TX interrupt drains it into the FIFO a
+       burst at a time, and writers only block while it is full
+      -input: the RX interrupts empty the FIFO into it, and read() copies out whatever is
+       ready, blocking (optionally with a timeout) only while nothing is; on a line-buffered
+       UART (a terminal) input only becomes ready a whole line at a time  */
+typedef struct uart
+{
+    PL011_t *dev;
+    uint8_t tx[UART_TX_SIZE];
+    size_t txHead;  // next byte to transmit
+    size_t txCount; // bytes waiting to be transmitted
+    wait_queue_t writers;
+    uint8_t rx[UART_RX_SIZE];
+    size_t rxHead;  // next byte to read
+    size_t rxCount; // bytes received and not yet read
+    size_t rxReady; // of those, bytes that can be read (through the last newline if line-buffered)
+    bool lines;     // line-buffered
+    wait_queue_t readers;
+} uart_t;
+
+extern uart_t uartTable[UART_PORTS];
+
+extern void uartInit();
+extern void uartWrite(ctx_t *ctx, uart_t *uart, uint8_t *x, size_t n, int flags);
+extern void uartRead(ctx_t *ctx, pcb_t *proc, uart_t *uart, uint8_t *x, size_t n, int timeout);
+extern void uartPutc(uart_t *uart, uint8_t x);
+extern void uartIrq(uart_t *uart);
+extern void uartTimers();
+extern void uartTableRemove(pid_t pid);
+
+#endif
@@ -0,0 +1,39 @@
+#include "./futex.h"
+
+/*  Futexes: a process sleeps on a user-space word, keyed by its address, only while the
+    word still holds the value it last saw; the word itself is managed with LDREX/STREX
+    in user space, so the kernel is entered only to sleep or to wake a sleeper.
+    Addresses hash into FUTEX_BUCKETS shared FIFO wait queues (pcb_t.waitKey = address).  */
+wait_queue_t futexTable[FUTEX_BUCKETS];
+
+void futexTableInit()
+{
+    memset(futexTable, 0, sizeof(futexTable));
+    return;
+}
+
+//  the wait queue addr hashes to
+wait_queue_t *futexBucket(uint32_t addr)
+{
+    return &futexTable[((addr >> 2) ^ (addr >> 8)) & (FUTEX_BUCKETS - 1)];
+}
+
+/*  block P_{current} until woken by futexWake on addr, unless *addr != expected
+      -r0 is set to 0 when woken, or -1 if *addr has already changed (or addr is unaligned)  */
+void futexWait(ctx_t *ctx, uint32_t addr, int expected)
+{
+    if ((addr & 0x3) != 0 || *(int *)addr != expected)
+    {
+        ctx->gpr[0] = -1;
+        return;
+    }
+    currentProc->waitKey = addr;
+    waitBlock(ctx, futexBucket(addr));
+    return;
+}
+
+//  wake up to n processes waiting on addr (longest waiting first), returning how many were woken
+int futexWake(uint32_t addr, int n)
+{
+    return waitWakeKey(futexBucket(addr), addr, n, 0);
+}
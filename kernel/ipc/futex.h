@@ -0,0 +1,17 @@
+#ifndef __FUTEX_H
+#define __FUTEX_H
+
+#include "../hilevel/hilevel.h"
+#include "../processTables/processTable.h"
+#include "./waitQueue.h"
+
+//  number of wait queues futex addresses are hashed into (a power of 2)
+#define FUTEX_BUCKETS (64)
+
+extern wait_queue_t futexTable[FUTEX_BUCKETS];
+
+extern void futexTableInit();
+extern void futexWait(ctx_t *ctx, uint32_t addr, int expected);
+extern int futexWake(uint32_t addr, int n);
+
+#endif
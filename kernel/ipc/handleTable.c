@@ -0,0 +1,82 @@
+#include "./handleTable.h"
+
+handle_entry_t handleTable[HANDLE_MAX];
+int handleTabEntries = 0;
+
+//  first free slot (-1 if the table is full)
+int handleFreeList = -1;
+
+//  puts every slot on the free list, at generation 1 (so no handle is 0)
+void handleTableInit()
+{
+    for (int i = HANDLE_MAX - 1; i >= 0; i--)
+    {
+        handleTable[i].type = HANDLE_FREE;
+        handleTable[i].generation = 1;
+        handleTable[i].object = NULL;
+        handleTable[i].nextFree = handleFreeList;
+        handleFreeList = i;
+    }
+    handleTabEntries = 0;
+    return;
+}
+
+//  returns a new handle for object, or -1 if the table is full - O(1)
+int handleAlloc(handle_type_t type, void *object)
+{
+    int index = handleFreeList;
+    if (index < 0)
+    {
+        return -1;
+    }
+    handleFreeList = handleTable[index].nextFree;
+    handleTable[index].type = type;
+    handleTable[index].object = object;
+    handleTabEntries++;
+    return (handleTable[index].generation << HANDLE_INDEX_BITS) | index;
+}
+
+//  the slot handle names, or NULL if it is out of range, free or from an earlier generation
+handle_entry_t *handleEntry(int handle)
+{
+    if (handle <= 0)
+    {
+        return NULL;
+    }
+    handle_entry_t *entry = &handleTable[handle & (HANDLE_MAX - 1)];
+    if (entry->type == HANDLE_FREE || entry->generation != ((uint32_t)handle >> HANDLE_INDEX_BITS))
+    {
+        return NULL;
+    }
+    return entry;
+}
+
+//  returns the object of the given type named by handle (NULL if the handle is stale or of another type) - O(1)
+void *handleLookup(int handle, handle_type_t type)
+{
+    handle_entry_t *entry = handleEntry(handle);
+    return (entry != NULL && entry->type == type) ? entry->object : NULL;
+}
+
+//  the type of object named by handle (HANDLE_FREE if the handle is stale)
+handle_type_t handleType(int handle)
+{
+    handle_entry_t *entry = handleEntry(handle);
+    return (entry == NULL) ? HANDLE_FREE : entry->type;
+}
+
+//  invalidates handle (and every copy of it) and returns its slot to the free list - O(1)
+void handleFree(int handle)
+{
+    handle_entry_t *entry = handleEntry(handle);
+    if (entry != NULL)
+    {
+        entry->type = HANDLE_FREE;
+        entry->object = NULL;
+        entry->generation = (entry->generation == HANDLE_GENERATION_MAX) ? 1 : entry->generation + 1;
+        entry->nextFree = handleFreeList;
+        handleFreeList = entry - handleTable;
+        handleTabEntries--;
+    }
+    return;
+}
@@ -0,0 +1,46 @@
+#ifndef __HANDLETABLE_H
+#define __HANDLETABLE_H
+
+#include "../hilevel/hilevel.h"
+
+/*  IPC objects are named in user space by handles: small integers indexing one global
+    table of typed kernel objects. A handle is (generation << HANDLE_INDEX_BITS) | index;
+    the generation of a slot changes every time it is freed, so a stale handle (or one
+    of the wrong type) is rejected by handleLookup in O(1) rather than reaching a reused
+    or freed object.  */
+
+#define HANDLE_INDEX_BITS (8)
+#define HANDLE_MAX (1 << HANDLE_INDEX_BITS)
+#define HANDLE_GENERATION_MAX (0x007FFFFF)
+
+typedef enum
+{
+    HANDLE_FREE,
+    HANDLE_SEM,
+    HANDLE_SHM,
+    HANDLE_MUTEX,
+    HANDLE_COND,
+    HANDLE_BARRIER,
+    HANDLE_RWLOCK,
+    HANDLE_PIPE,
+    HANDLE_POLLSET
+} handle_type_t;
+
+typedef struct
+{
+    handle_type_t type;
+    uint32_t generation;
+    void *object;
+    int nextFree; // index of the next free slot (while free), -1 at the end of the list
+} handle_entry_t;
+
+extern handle_entry_t handleTable[HANDLE_MAX];
+extern int handleTabEntries;
+
+extern void handleTableInit();
+extern int handleAlloc(handle_type_t type, void *object);
+extern void *handleLookup(int handle, handle_type_t type);
+extern handle_type_t handleType(int handle);
+extern void handleFree(int handle);
+
+#endif
@@ -0,0 +1,117 @@
+#include "./ipcCall.h"
+
+/*  L4-style synchronous IPC: a message is IPC_WORDS words carried in r1-r8, copied from
+    the saved context of the sender to that of the receiver (never through memory), and
+    where the receiver is already waiting the kernel switches straight to it with
+    dispatch() rather than going through schedule().  */
+endpoint_t *endpointTable = NULL;
+
+void ipcTableInit()
+{
+    endpointTable = kcalloc(MAX_PROCS, sizeof(endpoint_t));
+    return;
+}
+
+//  the endpoint of the process with the given PID (NULL if it doesn't exist)
+endpoint_t *ipcEndpoint(pid_t pid)
+{
+    int slot = procTableContains(pid);
+    return (slot < 0) ? NULL : &endpointTable[slot];
+}
+
+//  copy the message registers r1-r8 of one context into another
+void ipcCopy(ctx_t *to, ctx_t *from)
+{
+    memcpy(&to->gpr[1], &from->gpr[1], IPC_WORDS * sizeof(uint32_t));
+}
+
+/*  block P_{current} on queue and switch directly to next (which has just been made ready),
+    bypassing the scheduler: next runs on P_{current}'s time rather than waiting its turn  */
+void ipcSwitch(ctx_t *ctx, wait_queue_t *queue, pcb_t *next)
+{
+    pcb_t *proc = currentProc;
+
+    proc->status = STATUS_WAITING;
+    removeFromMLFQ(proc->pid);
+    waitQueuePush(queue, proc);
+    dispatch(ctx, proc, next);
+    return;
+}
+
+/*  ipc_call for P_{current}: send r1-r8 to dest and block until it replies
+      -if dest is waiting in ipc_reply_wait the message is handed over and dest runs at once,
+       otherwise P_{current} queues until dest next receives
+      -r0 is set to 0 (with the reply in r1-r8), or -1 if dest doesn't exist or exits  */
+void ipcCall(ctx_t *ctx, pid_t dest)
+{
+    endpoint_t *ep = ipcEndpoint(dest);
+    if (ep == NULL || dest == currentProc->pid)
+    {
+        ctx->gpr[0] = -1;
+        return;
+    }
+
+    pcb_t *server = waitQueuePop(&ep->receiver);
+    if (server == NULL)
+    {
+        //  the message stays in the saved registers until the server takes it
+        waitBlock(ctx, &ep->callers);
+        return;
+    }
+    ipcCopy(&server->ctx, ctx);
+    server->ctx.gpr[0] = currentProc->pid;
+    scheduleWake(server);
+    ipcSwitch(ctx, &ep->replies, server);
+    return;
+}
+
+/*  ipc_reply_wait for P_{current}: reply with r1-r8 to replyTo (none if IPC_NONE; -1 is the console), then
+    wait for the next call
+      -r0 is set to the PID of the caller, with its message in r1-r8
+      -with no caller queued, P_{current} blocks and the kernel switches straight back to the client  */
+void ipcReplyWait(ctx_t *ctx, pid_t replyTo)
+{
+    endpoint_t *ep = ipcEndpoint(currentProc->pid);
+    pcb_t *client = NULL;
+
+    if (replyTo != IPC_NONE)
+    {
+        int slot = procTableContains(replyTo);
+        if (slot >= 0 && waitQueueRemove(&ep->replies, &procTable[slot]))
+        {
+            client = &procTable[slot];
+            ipcCopy(&client->ctx, ctx);
+            client->ctx.gpr[0] = 0;
+            scheduleWake(client);
+        }
+    }
+
+    pcb_t *caller = waitQueuePop(&ep->callers);
+    if (caller != NULL)
+    {
+        ipcCopy(ctx, &caller->ctx);
+        ctx->gpr[0] = caller->pid;
+        waitQueuePush(&ep->replies, caller);
+        return;
+    }
+    if (client != NULL)
+    {
+        ipcSwitch(ctx, &ep->receiver, client);
+        return;
+    }
+    waitBlock(ctx, &ep->receiver);
+    return;
+}
+
+//  for the process with the given PID: fail the calls of its clients (it can no longer reply)
+void ipcTableRemove(pid_t pid)
+{
+    endpoint_t *ep = ipcEndpoint(pid);
+    if (ep != NULL)
+    {
+        waitWakeAll(&ep->callers, -1);
+        waitWakeAll(&ep->replies, -1);
+        memset(&ep->receiver, 0, sizeof(wait_queue_t));
+    }
+    return;
+}
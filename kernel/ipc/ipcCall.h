@@ -0,0 +1,29 @@
+#ifndef __IPCCALL_H
+#define __IPCCALL_H
+
+#include "../hilevel/hilevel.h"
+#include "../../user/libc.h"
+#include "../processTables/processTable.h"
+#include "../scheduling/scheduler.h"
+#include "../memory/kheap.h"
+#include "./waitQueue.h"
+
+/*  the synchronous IPC state of one process (as a server), indexed by process table slot
+      -callers: clients blocked in ipc_call until it next receives
+      -replies: clients it has received from, blocked until it replies
+      -receiver: itself, while blocked in ipc_reply_wait with no caller  */
+typedef struct
+{
+    wait_queue_t callers;
+    wait_queue_t replies;
+    wait_queue_t receiver;
+} endpoint_t;
+
+extern endpoint_t *endpointTable;
+
+extern void ipcTableInit();
+extern void ipcCall(ctx_t *ctx, pid_t dest);
+extern void ipcReplyWait(ctx_t *ctx, pid_t replyTo);
+extern void ipcTableRemove(pid_t pid);
+
+#endif
@@ -0,0 +1,236 @@
+#include "./mutexTable.h"
+#include <stdlib.h>
+
+//  singly linked list of every kernel mutex
+mutexb_t *mutexTable = NULL;
+int mutexTabEntries = 0;
+
+slab_cache_t mutexCache;
+
+//  mutexes start (and are freed) unlocked with no waiters
+void mutexCtor(void *obj)
+{
+    memset(obj, 0, sizeof(mutexb_t));
+}
+
+//  creates the mutex cache
+void mutexTableInit()
+{
+    slabCacheInit(&mutexCache, "mutex", sizeof(mutexb_t), sizeof(void *), &mutexCtor);
+    return;
+}
+
+//  creates an unlocked mutex, returning NULL if out of memory or handles
+mutexb_t *mutexTableAdd(pid_t creator)
+{
+    mutexb_t *entry = slabAlloc(&mutexCache);
+    if (entry != NULL)
+    {
+        entry->handle = handleAlloc(HANDLE_MUTEX, entry);
+        if (entry->handle < 0)
+        {
+            slabFree(&mutexCache, entry);
+            return NULL;
+        }
+        entry->creator = creator;
+        entry->next = mutexTable;
+        mutexTable = entry;
+        mutexTabEntries++;
+    }
+    return entry;
+}
+
+//  returns the kernel mutex handle names (NULL if it isn't a live mutex) - O(1)
+mutexb_t *mutexTabContains(int handle)
+{
+    return handleLookup(handle, HANDLE_MUTEX);
+}
+
+//  the mutex proc is blocked on (NULL if it isn't blocked on one)
+mutexb_t *mutexBlockedOn(pcb_t *proc)
+{
+    if (proc->waitOn == NULL)
+    {
+        return NULL;
+    }
+    for (mutexb_t *entry = mutexTable; entry != NULL; entry = entry->next)
+    {
+        if (proc->waitOn == &entry->waiters)
+        {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+//  the best (lowest) priority among the processes blocked on entry (0 if none)
+int mutexWaiterPriority(mutexb_t *entry)
+{
+    int p = 0;
+    for (pcb_t *waiter = entry->waiters.head; waiter != NULL; waiter = waiter->waitNext)
+    {
+        if (p == 0 || waiter->priority < p)
+        {
+            p = waiter->priority;
+        }
+    }
+    return p;
+}
+
+//  lend priority p to proc and on along the chain of owners of the mutexes each is blocked on
+void mutexBoost(pcb_t *proc, int p)
+{
+    //  a chain can't be longer than the process table (bounds a deadlocked cycle)
+    for (int depth = 0; proc != NULL && depth < MAX_PROCS; depth++)
+    {
+        //  owners further along were boosted at least this far when proc blocked
+        if (p <= 0 || proc->priority <= p)
+        {
+            return;
+        }
+        if (proc->inherited == 0)
+        {
+            proc->basePriority = proc->priority;
+        }
+        proc->inherited = p;
+        proc->priority = p;
+        scheduleRequeue(proc);
+
+        mutexb_t *next = mutexBlockedOn(proc);
+        proc = (next == NULL) ? NULL : next->owner;
+    }
+    return;
+}
+
+//  recompute what proc inherits from the mutexes it still holds, dropping back to its own priority if nothing
+void mutexRestore(pcb_t *proc)
+{
+    if (proc == NULL || proc->inherited == 0)
+    {
+        return;
+    }
+    int p = 0;
+    for (mutexb_t *entry = mutexTable; entry != NULL; entry = entry->next)
+    {
+        if (entry->owner == proc)
+        {
+            int q = mutexWaiterPriority(entry);
+            if (q != 0 && (p == 0 || q < p))
+            {
+                p = q;
+            }
+        }
+    }
+    if (p != 0 && p < proc->basePriority)
+    {
+        proc->inherited = p;
+        proc->priority = p;
+    }
+    else
+    {
+        proc->inherited = 0;
+        proc->priority = proc->basePriority;
+    }
+    scheduleRequeue(proc);
+    return;
+}
+
+/*  lock entry for P_{current}, blocking (and lending it's priority to the owner) if held
+      -r0 is set to 0 once P_{current} owns it, or -1 if it already does  */
+void mutexLock(ctx_t *ctx, mutexb_t *entry)
+{
+    if (entry->owner == NULL)
+    {
+        entry->owner = currentProc;
+        ctx->gpr[0] = 0;
+        return;
+    }
+    if (entry->owner == currentProc)
+    {
+        ctx->gpr[0] = -1;
+        return;
+    }
+    mutexBoost(entry->owner, currentProc->priority);
+    waitBlock(ctx, &entry->waiters);
+    return;
+}
+
+/*  unlock entry held by proc, handing it to the waiter of best priority (longest waiting first)
+      -returns -1 if proc isn't the owner  */
+int mutexUnlock(mutexb_t *entry, pcb_t *proc)
+{
+    if (entry->owner != proc)
+    {
+        return -1;
+    }
+
+    pcb_t *next = NULL;
+    for (pcb_t *waiter = entry->waiters.head; waiter != NULL; waiter = waiter->waitNext)
+    {
+        if (next == NULL || waiter->priority < next->priority)
+        {
+            next = waiter;
+        }
+    }
+    entry->owner = next;
+    if (next != NULL)
+    {
+        waitQueueRemove(&entry->waiters, next);
+        waitResume(next, 0);
+        //  the new owner inherits from whoever is still waiting
+        mutexBoost(next, mutexWaiterPriority(entry));
+    }
+    mutexRestore(proc);
+    return 0;
+}
+
+//  unlinks and frees a mutex; any waiters are woken with kmutex_lock returning -1
+void mutexTabDelete(mutexb_t *entry)
+{
+    mutexb_t **link = &mutexTable;
+    while (*link != NULL && *link != entry)
+    {
+        link = &(*link)->next;
+    }
+    if (*link == entry)
+    {
+        *link = entry->next;
+        handleFree(entry->handle);
+        waitWakeAll(&entry->waiters, -1);
+        pcb_t *owner = entry->owner;
+        entry->owner = NULL;
+        mutexRestore(owner);
+        //  return the mutex to its constructed state before freeing
+        mutexCtor(entry);
+        slabFree(&mutexCache, entry);
+        mutexTabEntries--;
+    }
+    return;
+}
+
+//  for the process with the given PID: stop waiting, release what it holds and destroy what it created
+void mutexTableRemove(pid_t pid)
+{
+    int slot = procTableContains(pid);
+    pcb_t *proc = (slot >= 0) ? &procTable[slot] : NULL;
+
+    mutexb_t *entry = mutexTable;
+    while (entry != NULL)
+    {
+        mutexb_t *next = entry->next;
+        if (proc != NULL && waitQueueRemove(&entry->waiters, proc))
+        {
+            mutexRestore(entry->owner);
+        }
+        if (proc != NULL && entry->owner == proc)
+        {
+            mutexUnlock(entry, proc);
+        }
+        if (entry->creator == pid)
+        {
+            mutexTabDelete(entry);
+        }
+        entry = next;
+    }
+    return;
+}
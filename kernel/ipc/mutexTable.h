@@ -0,0 +1,37 @@
+#ifndef __MUTEXTABLE_H
+#define __MUTEXTABLE_H
+
+#include "../hilevel/hilevel.h"
+#include "../../user/libc.h"
+#include "../processTables/processTable.h"
+#include "../scheduling/scheduler.h"
+#include "../memory/slab.h"
+#include "./waitQueue.h"
+#include "./handleTable.h"
+
+/*  kernel mutex with priority inheritance: while processes are blocked on it, the owner
+    runs at the best (lowest) priority among them, passed on along chains of owners that
+    are themselves blocked on mutexes, and drops back when it unlocks  */
+typedef struct mutexb
+{
+    pcb_t *owner;         // holder (NULL if unlocked)
+    int handle;
+    pid_t creator;        // destroyed when this process exits
+    wait_queue_t waiters; // processes blocked in kmutex_lock
+    struct mutexb *next;
+} mutexb_t;
+
+extern mutexb_t *mutexTable;
+extern int mutexTabEntries;
+
+extern slab_cache_t mutexCache;
+
+extern void mutexTableInit();
+extern mutexb_t *mutexTableAdd(pid_t creator);
+extern mutexb_t *mutexTabContains(int handle);
+extern void mutexTabDelete(mutexb_t *entry);
+extern void mutexLock(ctx_t *ctx, mutexb_t *entry);
+extern int mutexUnlock(mutexb_t *entry, pcb_t *proc);
+extern void mutexTableRemove(pid_t pid);
+
+#endif
@@ -0,0 +1,216 @@
+#include "./pipeTable.h"
+#include "SYS.h"
+#include "./pollTable.h"
+#include <stdlib.h>
+
+//  singly linked list of every pipe and channel
+pipeb_t *pipeTable = NULL;
+int pipeTabEntries = 0;
+
+slab_cache_t pipeCache;
+
+void pipeCtor(void *obj)
+{
+    memset(obj, 0, sizeof(pipeb_t));
+}
+
+//  creates the pipe cache
+void pipeTableInit()
+{
+    slabCacheInit(&pipeCache, "pipe", sizeof(pipeb_t), sizeof(void *), &pipeCtor);
+    return;
+}
+
+/*  creates an empty pipe of size bytes (msgSize = 0), or a channel of size / msgSize messages,
+    backed by pages; returns NULL if size is 0 or too large, or out of memory or handles  */
+pipeb_t *pipeTableAdd(pid_t owner, size_t size, size_t msgSize)
+{
+    int order = pageOrder(size);
+    if (size == 0 || order < 0)
+    {
+        return NULL;
+    }
+    pipeb_t *entry = slabAlloc(&pipeCache);
+    if (entry == NULL)
+    {
+        return NULL;
+    }
+    entry->buffer = page_alloc(order);
+    if (entry->buffer == NULL)
+    {
+        slabFree(&pipeCache, entry);
+        return NULL;
+    }
+    entry->handle = handleAlloc(HANDLE_PIPE, entry);
+    if (entry->handle < 0)
+    {
+        page_free(entry->buffer);
+        slabFree(&pipeCache, entry);
+        return NULL;
+    }
+    entry->owner = owner;
+    entry->size = size;
+    entry->msgSize = msgSize;
+    entry->next = pipeTable;
+    pipeTable = entry;
+    pipeTabEntries++;
+    return entry;
+}
+
+//  returns the pipe or channel handle names (NULL if it isn't live) - O(1)
+pipeb_t *pipeTabContains(int handle)
+{
+    return handleLookup(handle, HANDLE_PIPE);
+}
+
+//  unlinks and frees a pipe; blocked readers and writers find the handle gone and return -1
+void pipeTabDelete(pipeb_t *entry)
+{
+    pipeb_t **link = &pipeTable;
+    while (*link != NULL && *link != entry)
+    {
+        link = &(*link)->next;
+    }
+    if (*link == entry)
+    {
+        *link = entry->next;
+        pollNotify(entry->handle);
+        handleFree(entry->handle);
+        waitWakeAll(&entry->readers, -1);
+        waitWakeAll(&entry->writers, -1);
+        page_free(entry->buffer);
+        pipeCtor(entry);
+        slabFree(&pipeCache, entry);
+        pipeTabEntries--;
+    }
+    return;
+}
+
+//  copy n bytes from x into the ring (there must be room), wrapping at most once
+void pipeCopyIn(pipeb_t *entry, uint8_t *x, size_t n)
+{
+    size_t tail = (entry->head + entry->count) % entry->size;
+    size_t first = (n < entry->size - tail) ? n : entry->size - tail;
+
+    memcpy(entry->buffer + tail, x, first);
+    memcpy(entry->buffer, x + first, n - first);
+    entry->count += n;
+}
+
+//  copy n bytes from the ring into x (there must be as many), wrapping at most once
+void pipeCopyOut(pipeb_t *entry, uint8_t *x, size_t n)
+{
+    size_t first = (n < entry->size - entry->head) ? n : entry->size - entry->head;
+
+    memcpy(x, entry->buffer + entry->head, first);
+    memcpy(x + first, entry->buffer, n - first);
+    entry->head = (entry->head + n) % entry->size;
+    entry->count -= n;
+}
+
+/*  write for P_{current}; r0 is set to the bytes written, -1 on error or IPC_AGAIN if it would block
+      -pipe: blocking writes move all n bytes, blocking as often as needed (the saved x and n
+       are advanced each time, so the restarted call carries on); non-blocking move what fits
+      -channel: one whole message of msgSize bytes (n is ignored)  */
+void pipeWrite(ctx_t *ctx, pipeb_t *entry, uint8_t *x, size_t n, int flags)
+{
+    size_t room = entry->size - entry->count;
+    size_t moved;
+
+    if (entry->msgSize != 0)
+    {
+        n = entry->msgSize;
+        moved = (room >= n) ? n : 0;
+    }
+    else
+    {
+        moved = (room >= n) ? n : room;
+    }
+    pipeCopyIn(entry, x, moved);
+
+    //  one reader at a time is woken; it passes the wake on if data is left
+    if (moved != 0)
+    {
+        waitWake(&entry->readers, 0);
+        pollNotify(entry->handle);
+    }
+
+    if (moved == n || (flags & IPC_NONBLOCK))
+    {
+        ctx->gpr[0] = (moved == 0 && n != 0) ? IPC_AGAIN : moved;
+        return;
+    }
+    ctx->gpr[1] = (uint32_t)(x + moved);
+    ctx->gpr[2] = n - moved;
+    waitBlockRestart(ctx, &entry->writers);
+    return;
+}
+
+/*  read for P_{current}; r0 is set to the bytes read, -1 on error or IPC_AGAIN if it would block
+      -pipe: up to n bytes, blocking only while the pipe is empty
+      -channel: one whole message of msgSize bytes (n is ignored)  */
+void pipeRead(ctx_t *ctx, pipeb_t *entry, uint8_t *x, size_t n, int flags)
+{
+    if (entry->msgSize != 0)
+    {
+        n = entry->msgSize;
+    }
+    size_t moved = (entry->count >= n) ? n : ((entry->msgSize != 0) ? 0 : entry->count);
+
+    if (moved == 0 && n != 0)
+    {
+        if (flags & IPC_NONBLOCK)
+        {
+            ctx->gpr[0] = IPC_AGAIN;
+            return;
+        }
+        waitBlockRestart(ctx, &entry->readers);
+        return;
+    }
+    pipeCopyOut(entry, x, moved);
+
+    waitWake(&entry->writers, 0);
+    pollNotify(entry->handle);
+    //  pass the wake on to the next reader while data is left
+    if (entry->count != 0)
+    {
+        waitWake(&entry->readers, 0);
+    }
+    ctx->gpr[0] = moved;
+    return;
+}
+
+//  on the timer interrupt: end every read (through a descriptor) whose deadline has passed, returning 0
+void pipeTimers()
+{
+    uint32_t now = SYSCONF->COUNTER_24MHZ;
+    for (pipeb_t *entry = pipeTable; entry != NULL; entry = entry->next)
+    {
+        waitExpire(&entry->readers, now);
+    }
+    return;
+}
+
+//  for the process with the given PID: stop waiting and destroy the pipes it created
+void pipeTableRemove(pid_t pid)
+{
+    int slot = procTableContains(pid);
+    pcb_t *proc = (slot >= 0) ? &procTable[slot] : NULL;
+
+    pipeb_t *entry = pipeTable;
+    while (entry != NULL)
+    {
+        pipeb_t *next = entry->next;
+        if (proc != NULL)
+        {
+            waitQueueRemove(&entry->readers, proc);
+            waitQueueRemove(&entry->writers, proc);
+        }
+        if (entry->owner == pid)
+        {
+            pipeTabDelete(entry);
+        }
+        entry = next;
+    }
+    return;
+}
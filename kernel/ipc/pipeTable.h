@@ -0,0 +1,43 @@
+#ifndef __PIPETABLE_H
+#define __PIPETABLE_H
+
+#include "../hilevel/hilevel.h"
+#include "../../user/libc.h"
+#include "../processTables/processTable.h"
+#include "../memory/slab.h"
+#include "../memory/buddy.h"
+#include "./waitQueue.h"
+#include "./handleTable.h"
+
+/*  bounded ring buffer, either a byte pipe (msgSize = 0: reads and writes move any number
+    of bytes) or a message channel (every send/recv moves exactly one msgSize message)
+      -readers block while it is empty, writers while it is full  */
+typedef struct pipeb
+{
+    int handle;
+    pid_t owner; // destroyed when this process exits
+    uint8_t *buffer;
+    size_t size;    // capacity in bytes
+    size_t msgSize; // 0 for a byte pipe
+    size_t head;    // next byte to read
+    size_t count;   // bytes held
+    wait_queue_t readers;
+    wait_queue_t writers;
+    struct pipeb *next;
+} pipeb_t;
+
+extern pipeb_t *pipeTable;
+extern int pipeTabEntries;
+
+extern slab_cache_t pipeCache;
+
+extern void pipeTableInit();
+extern pipeb_t *pipeTableAdd(pid_t owner, size_t size, size_t msgSize);
+extern pipeb_t *pipeTabContains(int handle);
+extern void pipeTabDelete(pipeb_t *entry);
+extern void pipeWrite(ctx_t *ctx, pipeb_t *entry, uint8_t *x, size_t n, int flags);
+extern void pipeRead(ctx_t *ctx, pipeb_t *entry, uint8_t *x, size_t n, int flags);
+extern void pipeTimers();
+extern void pipeTableRemove(pid_t pid);
+
+#endif
@@ -0,0 +1,433 @@
+#include "./pollTable.h"
+#include "SYS.h"
+#include "../io/ioRing.h"
+
+/*  Waiting on many objects at once: a process blocked in poll or pollset_wait sits on pollQueue
+    (waitKey = 0 for poll, with its array in its saved r0/r1, or the set handle for pollset_wait),
+    and an object that changes wakes every poller interested in it to scan again (the system call
+    is restarted). Objects only readable through the kernel (pipes and channels) report POLLIN and
+    POLLOUT as levels; a semaphore has no such moment (posts usually stay in user space), so a
+    poller takes it instead, as sem_wait would: while blocked it counts as a waiter on each
+    semaphore it polls, so a post enters the kernel and is handed to it (at most one semaphore
+    per call). Timeouts are checked on the timer interrupt, so are only as fine as its period.  */
+pollb_t *pollTable = NULL;
+wait_queue_t pollQueue;
+
+slab_cache_t pollCache;
+
+void pollCtor(void *obj)
+{
+    memset(obj, 0, sizeof(pollb_t));
+}
+
+//  creates the interest set cache
+void pollTableInit()
+{
+    memset(&pollQueue, 0, sizeof(pollQueue));
+    slabCacheInit(&pollCache, "pollset", sizeof(pollb_t), sizeof(void *), &pollCtor);
+    return;
+}
+
+//  the interest of a blocked poller: its own array (poll) or its set's (pollset_wait)
+int pollInterest(pcb_t *proc, pollfd_t **fds)
+{
+    if (proc->waitKey == 0)
+    {
+        *fds = (pollfd_t *)proc->ctx.gpr[0];
+        return (int)proc->ctx.gpr[1];
+    }
+    pollb_t *set = pollTabContains((int)proc->waitKey);
+    *fds = (set == NULL) ? NULL : set->entries;
+    return (set == NULL) ? 0 : set->length;
+}
+
+//  true if the poller watches handle for any of events
+bool pollWatches(pcb_t *proc, int handle, int events)
+{
+    pollfd_t *fds;
+    int n = pollInterest(proc, &fds);
+    for (int i = 0; i < n; i++)
+    {
+        if (fds[i].handle == handle && (fds[i].events & events))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*  the events of handle ready now (POLLERR if it isn't a live handle)
+      -a ready semaphore is taken (*taken is then set, so at most one is taken per scan)  */
+int pollReady(int handle, int events, bool *taken)
+{
+    switch (handleType(handle))
+    {
+    case HANDLE_FREE:
+        return POLLERR;
+    case HANDLE_SEM:
+    {
+        semb_t *entry = semTabContains(handle);
+        if ((events & POLLIN) && !*taken && *entry->value > 0)
+        {
+            (*entry->value)--;
+            *taken = true;
+            return POLLIN;
+        }
+        return 0;
+    }
+    case HANDLE_PIPE:
+    {
+        pipeb_t *entry = pipeTabContains(handle);
+        size_t unit = (entry->msgSize != 0) ? entry->msgSize : 1;
+        int r = 0;
+        if (entry->count >= unit)
+        {
+            r |= POLLIN;
+        }
+        if (entry->size - entry->count >= unit)
+        {
+            r |= POLLOUT;
+        }
+        return r & events;
+    }
+    default:
+        return 0;
+    }
+}
+
+//  count proc as a waiter on (waiting = true), or stop counting it on, each semaphore it polls bar except
+void pollSemWaiter(pcb_t *proc, bool waiting, int except)
+{
+    pollfd_t *fds;
+    int n = pollInterest(proc, &fds);
+    for (int i = 0; i < n; i++)
+    {
+        semb_t *entry = semTabContains(fds[i].handle);
+        if (entry != NULL && (fds[i].events & POLLIN) && fds[i].handle != except)
+        {
+            *entry->value += waiting ? -1 : 1;
+        }
+    }
+}
+
+/*  scan fds for poll: set every revents, returning how many are non-zero
+      -or for pollset_wait (out != NULL): copy up to max ready entries to out, skipping (and disarming) edge-triggered ones  */
+int pollScan(pollfd_t *fds, int n, pollfd_t *out, int max)
+{
+    bool taken = false;
+    int ready = 0;
+
+    for (int i = 0; i < n && (out == NULL || ready < max); i++)
+    {
+        //  a semaphore is taken by every report, so it is never edge-triggered
+        if (out != NULL && (fds[i].events & POLLET) && fds[i].revents == 0 && handleType(fds[i].handle) != HANDLE_SEM)
+        {
+            continue;
+        }
+        int r = pollReady(fds[i].handle, fds[i].events, &taken);
+        if (out == NULL)
+        {
+            fds[i].revents = r;
+        }
+        else if (r != 0)
+        {
+            fds[i].revents = 0;
+            out[ready].handle = fds[i].handle;
+            out[ready].events = fds[i].events;
+            out[ready].revents = r;
+        }
+        ready += (r != 0);
+    }
+    return ready;
+}
+
+/*  the deadline timeout ms from now (never 0, which means none); deadlines are compared as int32_t,
+    so timeout must be at most POLL_TIMEOUT_MAX (callers reject longer ones)  */
+uint32_t pollDeadline(int timeout)
+{
+    uint32_t deadline = SYSCONF->COUNTER_24MHZ + (uint32_t)timeout * (24000000 / 1000);
+    return (deadline == 0) ? 1 : deadline;
+}
+
+/*  block P_{current} (with interest key) unless something was ready, the timeout is 0 or its deadline
+    has passed; a restarted wait keeps the deadline it first blocked with
+      -otherwise r0 is set to ready (0 on timeout)  */
+void pollBlock(ctx_t *ctx, int ready, uint32_t key, int timeout)
+{
+    pcb_t *proc = currentProc;
+    bool expired = proc->waitDeadline != 0 && (int32_t)(SYSCONF->COUNTER_24MHZ - proc->waitDeadline) >= 0;
+
+    if (ready > 0 || timeout == 0 || expired)
+    {
+        proc->waitDeadline = 0;
+        ctx->gpr[0] = ready;
+        return;
+    }
+    if (timeout > 0 && proc->waitDeadline == 0)
+    {
+        proc->waitDeadline = pollDeadline(timeout);
+    }
+    proc->waitKey = key;
+    pollSemWaiter(proc, true, -1);
+    if (!waitBlockRestart(ctx, &pollQueue))
+    {
+        //  nothing else can run: the system call is retried, registering again
+        pollSemWaiter(proc, false, -1);
+    }
+    return;
+}
+
+/*  poll for P_{current}: wait up to timeout ms (< 0 for ever, 0 not at all) for any of fds to be ready
+      -r0 is set to the number with non-zero revents (0 on timeout), or -1 if timeout is over
+       POLL_TIMEOUT_MAX (checked before scanning, which may take semaphores)  */
+void pollFds(ctx_t *ctx, pollfd_t *fds, int n, int timeout)
+{
+    if (timeout > POLL_TIMEOUT_MAX)
+    {
+        ctx->gpr[0] = -1;
+        return;
+    }
+    pollBlock(ctx, pollScan(fds, n, NULL, 0), 0, timeout);
+    return;
+}
+
+//  creates an empty interest set, returning NULL if out of memory or handles
+pollb_t *pollTableAdd(pid_t owner)
+{
+    pollb_t *set = slabAlloc(&pollCache);
+    if (set == NULL)
+    {
+        return NULL;
+    }
+    set->handle = handleAlloc(HANDLE_POLLSET, set);
+    if (set->handle < 0)
+    {
+        slabFree(&pollCache, set);
+        return NULL;
+    }
+    set->owner = owner;
+    set->next = pollTable;
+    pollTable = set;
+    return set;
+}
+
+//  returns the interest set handle names (NULL if it isn't live) - O(1)
+pollb_t *pollTabContains(int handle)
+{
+    return handleLookup(handle, HANDLE_POLLSET);
+}
+
+//  take a blocked poller off pollQueue, so it stops counting as a waiter on its semaphores (bar except)
+void pollLeave(pcb_t *proc, int except)
+{
+    pollSemWaiter(proc, false, except);
+    waitQueueRemove(&pollQueue, proc);
+}
+
+//  end a blocked poller's system call now (rather than restarting it), returning r
+void pollFinish(pcb_t *proc, int except, uint32_t r)
+{
+    pollLeave(proc, except);
+    proc->waitDeadline = 0;
+    proc->ctx.pc += 4;
+    proc->waitRestart = false;
+    waitResume(proc, r);
+}
+
+//  wake every blocked poller interested in handle (with key, if key != 0) to scan again
+void pollRescan(int handle, uint32_t key)
+{
+    pcb_t *proc = pollQueue.head;
+    while (proc != NULL)
+    {
+        pcb_t *next = proc->waitNext;
+        if ((key == 0 || proc->waitKey == key) && (handle == 0 || pollWatches(proc, handle, ~0)))
+        {
+            pollLeave(proc, -1);
+            waitResume(proc, 0);
+        }
+        proc = next;
+    }
+}
+
+/*  add (POLL_ADD), change (POLL_MOD) or remove (POLL_DEL) the interest of set in handle
+      -returns 0, or -1 if the handle is (or, for POLL_ADD, isn't) already there or out of memory  */
+int pollCtl(pollb_t *set, int op, int handle, int events)
+{
+    int i = 0;
+    while (i < set->length && set->entries[i].handle != handle)
+    {
+        i++;
+    }
+    if ((op == POLL_ADD) != (i == set->length))
+    {
+        return -1;
+    }
+    //  blocked waiters have registered on the old entries: let them scan the new ones
+    pollRescan(0, set->handle);
+
+    if (op == POLL_ADD && set->length == set->size)
+    {
+        int size = (set->size == 0) ? 8 : set->size * 2;
+        pollfd_t *entries = krealloc(set->entries, size * sizeof(pollfd_t));
+        if (entries == NULL)
+        {
+            return -1;
+        }
+        set->entries = entries;
+        set->size = size;
+    }
+    if (op == POLL_DEL)
+    {
+        set->entries[i] = set->entries[--set->length];
+        return 0;
+    }
+    if (op == POLL_ADD)
+    {
+        set->length++;
+    }
+    set->entries[i].handle = handle;
+    set->entries[i].events = events;
+    set->entries[i].revents = 1;
+    return 0;
+}
+
+/*  pollset_wait for P_{current}: wait up to timeout ms for any entry of set to be ready
+      -r0 is set to the number of ready entries copied to out (at most max; 0 on timeout), or -1 if
+       timeout is over POLL_TIMEOUT_MAX  */
+void pollWait(ctx_t *ctx, pollb_t *set, pollfd_t *out, int max, int timeout)
+{
+    if (timeout > POLL_TIMEOUT_MAX)
+    {
+        ctx->gpr[0] = -1;
+        return;
+    }
+    pollBlock(ctx, pollScan(set->entries, set->length, out, max), set->handle, timeout);
+    return;
+}
+
+//  unlinks and frees a set; its blocked waiters find the handle gone and return -1
+void pollTabDelete(pollb_t *set)
+{
+    pollb_t **link = &pollTable;
+    while (*link != NULL && *link != set)
+    {
+        link = &(*link)->next;
+    }
+    if (*link == set)
+    {
+        *link = set->next;
+        pollRescan(0, set->handle);
+        handleFree(set->handle);
+        kfree(set->entries);
+        pollCtor(set);
+        slabFree(&pollCache, set);
+    }
+    return;
+}
+
+//  handle has changed (or is about to be freed): arm its edge-triggered entries and wake its pollers
+void pollNotify(int handle)
+{
+    for (pollb_t *set = pollTable; set != NULL; set = set->next)
+    {
+        for (int i = 0; i < set->length; i++)
+        {
+            if (set->entries[i].handle == handle)
+            {
+                set->entries[i].revents = 1;
+            }
+        }
+    }
+    pollRescan(handle, 0);
+    //  asynchronous operations waiting on it may now finish
+    ioPoll();
+    return;
+}
+
+//  the units pollers have taken from the semaphore's value while they wait (one per POLLIN interest in it)
+int pollSemWaiters(semb_t *entry)
+{
+    int units = 0;
+    for (pcb_t *proc = pollQueue.head; proc != NULL; proc = proc->waitNext)
+    {
+        pollfd_t *fds;
+        int n = pollInterest(proc, &fds);
+        for (int i = 0; i < n; i++)
+        {
+            units += (fds[i].handle == entry->handle && (fds[i].events & POLLIN)) ? 1 : 0;
+        }
+    }
+    return units;
+}
+
+/*  sem_post found no process blocked in sem_wait: hand the unit to the longest waiting poller of the
+    semaphore instead, which returns at once with just it ready; false if there is none  */
+bool pollSemPost(semb_t *entry)
+{
+    for (pcb_t *proc = pollQueue.head; proc != NULL; proc = proc->waitNext)
+    {
+        if (!pollWatches(proc, entry->handle, POLLIN))
+        {
+            continue;
+        }
+        pollfd_t *fds;
+        int n = pollInterest(proc, &fds);
+        if (proc->waitKey == 0)
+        {
+            for (int i = 0; i < n; i++)
+            {
+                fds[i].revents = (fds[i].handle == entry->handle) ? POLLIN : 0;
+            }
+        }
+        else if ((int)proc->ctx.gpr[2] > 0)
+        {
+            pollfd_t *out = (pollfd_t *)proc->ctx.gpr[1];
+            out->handle = entry->handle;
+            out->events = POLLIN;
+            out->revents = POLLIN;
+        }
+        //  the post has already taken this poller off the semaphore's count
+        pollFinish(proc, entry->handle, 1);
+        return true;
+    }
+    return false;
+}
+
+//  on the timer interrupt: end every poll whose deadline has passed, returning 0
+void pollTimers()
+{
+    uint32_t now = SYSCONF->COUNTER_24MHZ;
+    pcb_t *proc = pollQueue.head;
+    while (proc != NULL)
+    {
+        pcb_t *next = proc->waitNext;
+        if (proc->waitDeadline != 0 && (int32_t)(now - proc->waitDeadline) >= 0)
+        {
+            pollFinish(proc, -1, 0);
+        }
+        proc = next;
+    }
+    return;
+}
+
+//  for the process with the given PID: stop polling and destroy the sets it created
+void pollTableRemove(pid_t pid)
+{
+    int slot = procTableContains(pid);
+    if (slot >= 0 && procTable[slot].waitOn == &pollQueue)
+    {
+        pollLeave(&procTable[slot], -1);
+    }
+    pollb_t *set = pollTable;
+    while (set != NULL)
+    {
+        pollb_t *next = set->next;
+        if (set->owner == pid)
+        {
+            pollTabDelete(set);
+        }
+        set = next;
+    }
+    return;
+}
@@ -0,0 +1,47 @@
+#ifndef __POLLTABLE_H
+#define __POLLTABLE_H
+
+#include "../hilevel/hilevel.h"
+#include "../../user/libc.h"
+#include "../processTables/processTable.h"
+#include "../scheduling/scheduler.h"
+#include "../memory/slab.h"
+#include "../memory/kheap.h"
+#include "./waitQueue.h"
+#include "./handleTable.h"
+#include "./semTable.h"
+#include "./pipeTable.h"
+
+/*  persistent interest set (epoll-like), named in user space by handle
+      -entries keep revents as the edge-triggered "armed" flag: set when added and whenever the
+       object changes, cleared when the entry is reported  */
+typedef struct pollb
+{
+    int handle;
+    pid_t owner;
+    pollfd_t *entries;
+    int length;
+    int size;
+    struct pollb *next;
+} pollb_t;
+
+extern pollb_t *pollTable;
+extern wait_queue_t pollQueue;
+
+extern slab_cache_t pollCache;
+
+extern void pollTableInit();
+extern void pollFds(ctx_t *ctx, pollfd_t *fds, int n, int timeout);
+extern pollb_t *pollTableAdd(pid_t owner);
+extern pollb_t *pollTabContains(int handle);
+extern int pollCtl(pollb_t *set, int op, int handle, int events);
+extern void pollWait(ctx_t *ctx, pollb_t *set, pollfd_t *out, int max, int timeout);
+extern void pollTabDelete(pollb_t *set);
+extern void pollNotify(int handle);
+extern bool pollSemPost(semb_t *entry);
+extern int pollSemWaiters(semb_t *entry);
+extern uint32_t pollDeadline(int timeout);
+extern void pollTimers();
+extern void pollTableRemove(pid_t pid);
+
+#endif
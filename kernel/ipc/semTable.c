@@ -1,166 +1,419 @@
 #include "./semTable.h"
+#include "./pollTable.h"
 #include <stdlib.h>
+#include "SYS.h"
+#include "../../user/console.h"
 
-semb_t *semTable;
-int semTabSize = 0;
+//  singly linked list of every semaphore
+semb_t *semTable = NULL;
 int semTabEntries = 0;
 
-/*  makes sure all semTable entries are adjacent 
-    O(n^2)  */
-void semTabDefrag()
+slab_cache_t semCache;
+
+//  semaphores start (and are freed) with no waiters
+void semCtor(void *obj)
+{
+    memset(obj, 0, sizeof(semb_t));
+}
+
+//  creates the semaphore cache
+void semTableInit()
+{
+    slabCacheInit(&semCache, "sem", sizeof(semb_t), sizeof(void *), &semCtor);
+    return;
+}
+
+//  creates a semaphore owned by owner on the user space word value (set to 0), returning NULL if out of memory or handles
+semb_t *semTableAdd(pid_t owner, int *value)
 {
-    for (int i = 0; i < semTabSize; i++)
+    semb_t *entry = slabAlloc(&semCache);
+    if (entry != NULL)
     {
-        if (semTable[i].waitingPid == 0)
+        entry->handle = handleAlloc(HANDLE_SEM, entry);
+        if (entry->handle < 0)
         {
-            for (int j = i + 1; j < semTabSize; j++)
-            {
-                if (semTable[i].waitingPid != 0)
-                {
-                    memcpy(&semTable[i], &semTable[j], sizeof(semb_t)); // set procTable[i] to procTable[j]
-                    memset(&semTable[j], 0, sizeof(semb_t));            // set procTable[j] to 0
-                    break;
-                }
-            }
+            slabFree(&semCache, entry);
+            return NULL;
         }
+        entry->value = value;
+        *entry->value = 0;
+        entry->owner = owner;
+        entry->next = semTable;
+        semTable = entry;
+        semTabEntries++;
     }
-    return;
+    return entry;
+}
+
+//  returns the semaphore handle names (NULL if it isn't a live semaphore) - O(1)
+semb_t *semTabContains(int handle)
+{
+    return handleLookup(handle, HANDLE_SEM);
 }
 
-//  returns index of addr in the semTable (-1 if not in semTable)
-int semTabContains(sem_t sem)
+#ifdef KERNEL_LOCK_STATS
+//  charge ticks spent blocked by proc to the semaphore and its top waiters (replacing the least waited if full)
+void semStatWaited(semstat_t *stats, pid_t pid, uint32_t ticks)
 {
-    for (int i = 0; i < semTabSize; i++)
+    int slot = 0;
+    for (int i = 0; i < SEM_STAT_PIDS; i++)
     {
-        if (semTable[i].sem == sem && semTable[i].waitingPid != 0)
+        if (stats->top[i].pid == pid && stats->top[i].waits != 0)
         {
-            return i;
+            slot = i;
+            break;
+        }
+        if (stats->top[i].ticks < stats->top[slot].ticks)
+        {
+            slot = i;
         }
     }
-    return -1;
+    if (stats->top[slot].pid != pid || stats->top[slot].waits == 0)
+    {
+        stats->top[slot].pid = pid;
+        stats->top[slot].waits = 0;
+        stats->top[slot].ticks = 0;
+    }
+    stats->top[slot].waits++;
+    stats->top[slot].ticks += ticks;
+
+    stats->acquired++;
+    stats->waitTicks += ticks;
+    if (ticks > stats->waitMax)
+    {
+        stats->waitMax = ticks;
+    }
+}
+#endif
+
+//  P_{current} is about to block in sem_wait on the semaphore (or has taken it at once if it won't)
+void semTableWaiting(semb_t *entry)
+{
+#ifdef KERNEL_LOCK_STATS
+    if (*entry->value > 0)
+    {
+        entry->stats.acquired++;
+        return;
+    }
+    entry->stats.contended++;
+    //  the time it started waiting (waitKey is otherwise unused by sem_wait)
+    currentProc->waitKey = SYSCONF->COUNTER_24MHZ;
+#endif
+    return;
 }
 
-//  gets the PID of the owner of the semaphore
-pid_t semGetOwner(sem_t sem)
+//  wakes the longest waiting process (its sem_wait returns 0), returning false if there are no waiters - O(1)
+bool semTableNotify(semb_t *entry)
 {
-    for (int i = 0; i < semTabSize; i++)
+    pcb_t *proc = waitWake(&entry->waiters, 0);
+#ifdef KERNEL_LOCK_STATS
+    entry->stats.posts++;
+    if (proc != NULL)
     {
-        if (semTable[i].sem == sem)
+        semStatWaited(&entry->stats, proc->pid, SYSCONF->COUNTER_24MHZ - proc->waitKey);
+    }
+#endif
+    return proc != NULL;
+}
+
+bool semopNotify(semb_t *entry);
+
+/*  offer one unit already added to the value: it goes to the longest waiting process blocked in
+    sem_wait, else to the semops parked on the semaphore, else to a process polling it (if no semop
+    took it); returns false if nobody did  */
+bool semTableOffer(semb_t *entry)
+{
+    return semTableNotify(entry) || semopNotify(entry) || pollSemPost(entry);
+}
+
+//  post one unit, offering it if processes are waiting
+void semTablePost(semb_t *entry)
+{
+    bool waiting = *entry->value < 0;
+
+    (*entry->value)++;
+    if (waiting)
+    {
+        semTableOffer(entry);
+    }
+    return;
+}
+
+/*  units of the semaphore nobody has taken: its value plus the units every process waiting on it
+    (in sem_wait, a parked semop or poll) has taken from the value  */
+int semTableFree(semb_t *entry)
+{
+    int units = *entry->value + entry->waiters.length + pollSemWaiters(entry);
+    for (pcb_t *proc = entry->semops.head; proc != NULL; proc = proc->waitNext)
+    {
+        units += proc->waitKey;
+    }
+    return units;
+}
+
+//  the semaphore ops[i] names (NULL if it isn't a live one)
+semb_t *semopEntry(sembuf_t *op)
+{
+    semb_t *entry = semTabContains(op->sem->handle);
+    return (entry != NULL && entry->value == &op->sem->value) ? entry : NULL;
+}
+
+//  true if every op of ops names a live semaphore, each a different one - O(n^2)
+bool semopValid(sembuf_t *ops, int n)
+{
+    for (int i = 0; i < n; i++)
+    {
+        if (semopEntry(&ops[i]) == NULL)
         {
-            return semTable[i].owner;
+            return false;
+        }
+        for (int j = 0; j < i; j++)
+        {
+            if (ops[j].sem == ops[i].sem)
+            {
+                return false;
+            }
         }
     }
-    return 0;
+    return true;
 }
 
-//  returns true if the given (sem, pid, owner) entry is already in the table
-bool semTabDuplicate(sem_t sem, pid_t pid, pid_t owner)
+/*  apply ops if every decrement can proceed (value >= -op), returning -1; otherwise apply none
+    and return the index of the first op that can't  */
+int semopTry(sembuf_t *ops, int n)
 {
-    for (int i = 0; i < semTabSize; i++)
+    for (int i = 0; i < n; i++)
     {
-        if (semTable[i].sem == sem && semTable[i].waitingPid == pid && semTable[i].owner == owner)
+        if (ops[i].op < 0 && *semopEntry(&ops[i])->value < -ops[i].op)
         {
-            return true;
+            return i;
+        }
+    }
+    for (int i = 0; i < n; i++)
+    {
+        if (ops[i].op < 0)
+        {
+            *semopEntry(&ops[i])->value += ops[i].op;
         }
     }
-    return false;
+    //  increments last, so waiters they wake see the decrements
+    for (int i = 0; i < n; i++)
+    {
+        for (int k = 0; k < ops[i].op; k++)
+        {
+            semTablePost(semopEntry(&ops[i]));
+        }
+    }
+    return -1;
 }
 
-//  initialises sem_t entry in semTable and initialises semTable
-//    -dynamically resizing
-void semTableAdd(sem_t sem, pid_t pid, pid_t owner)
+//  park proc (blocked in semop) on the semaphore of op, counting it as waiting for -op units
+void semopPark(pcb_t *proc, sembuf_t *op)
 {
-    if (!semTabDuplicate(sem, pid, owner))
+    semb_t *entry = semopEntry(op);
+
+    proc->waitKey = -op->op;
+    *entry->value -= proc->waitKey;
+    waitQueuePush(&entry->semops, proc);
+}
+
+/*  the semaphore has gained a unit: re-evaluate only the semops parked on it, in arrival order; each
+    either proceeds (returning 0) or is parked again on whichever semaphore now stops it
+      -returns true if any proceeded (taking the unit)  */
+bool semopNotify(semb_t *entry)
+{
+    wait_queue_t parked = entry->semops;
+    bool proceeded = false;
+
+    memset(&entry->semops, 0, sizeof(wait_queue_t));
+    for (pcb_t *proc = parked.head; proc != NULL; proc = parked.head)
     {
-        //  if the process table is full, resize
-        if (semTabEntries >= semTabSize && semTabSize > 0)
+        waitQueuePop(&parked);
+        *entry->value += proc->waitKey;
+
+        sembuf_t *ops = (sembuf_t *)proc->ctx.gpr[0];
+        int n = (int)proc->ctx.gpr[1];
+        //  another semaphore of the vector may have been destroyed while it was parked on this one
+        if (!semopValid(ops, n))
         {
-            semTabSize = semTabSize * 2;
-            semTable = realloc(semTable, semTabSize * sizeof(semb_t));
+            waitResume(proc, -1);
+            continue;
         }
-        else
+        int blocked = semopTry(ops, n);
+        if (blocked < 0)
         {
-            semTabDefrag();
+            proceeded = true;
+            waitResume(proc, 0);
         }
-        //  if this is the first entry, malloc
-        if (semTabSize == 0)
+        else
         {
-            semTable = malloc(sizeof(semb_t));
-            semTabSize++;
+            semopPark(proc, &ops[blocked]);
         }
+    }
+    return proceeded;
+}
 
-        semTable[semTabEntries].sem = sem;
-        semTable[semTabEntries].waitingPid = pid;
-        semTable[semTabEntries].owner = owner;
+/*  semop for P_{current}: apply the n increments/decrements of ops (each to a different semaphore)
+    atomically, blocking until every decrement can proceed at once
+      -r0 is set to 0, or -1 if an op names no semaphore or the same one as another op (or one is
+       destroyed while blocked)  */
+void semTableOp(ctx_t *ctx, sembuf_t *ops, int n)
+{
+    if (!semopValid(ops, n))
+    {
+        ctx->gpr[0] = -1;
+        return;
+    }
+    int blocked = semopTry(ops, n);
+    if (blocked < 0)
+    {
+        ctx->gpr[0] = 0;
+        return;
+    }
 
-        semTabEntries++;
+    //  park on the first semaphore that stops it; posts to that one re-evaluate the whole vector
+    semb_t *entry = semopEntry(&ops[blocked]);
+    currentProc->waitKey = -ops[blocked].op;
+    *entry->value -= currentProc->waitKey;
+    if (!waitBlock(ctx, &entry->semops))
+    {
+        //  nothing else can run: semop is retried
+        *entry->value += currentProc->waitKey;
+    }
+    return;
+}
+
+//  unlinks and frees a semaphore; any waiters are woken with sem_wait returning -1
+void semTabDelete(semb_t *entry)
+{
+    semb_t **link = &semTable;
+    while (*link != NULL && *link != entry)
+    {
+        link = &(*link)->next;
+    }
+    if (*link == entry)
+    {
+        *link = entry->next;
+        pollNotify(entry->handle);
+        handleFree(entry->handle);
+        waitWakeAll(&entry->waiters, -1);
+        waitWakeAll(&entry->semops, -1);
+        //  return the semaphore to its constructed state before freeing
+        semCtor(entry);
+        slabFree(&semCache, entry);
+        semTabEntries--;
     }
     return;
 }
 
-//  set status of all waiting processes to STATUS_READY and removes entry from semTable
-void semTableNotify(sem_t sem)
+//  takes the process with the given PID out of any wait queue and destroys every semaphore it owns
+void semTableRemove(pid_t pid)
 {
-    int index = semTabContains(sem);
+    int slot = procTableContains(pid);
+    pcb_t *proc = (slot >= 0) ? &procTable[slot] : NULL;
 
-    while (index >= 0)
+    semb_t *entry = semTable;
+    while (entry != NULL)
     {
-        if (semTable[index].waitingPid != 0)
+        semb_t *next = entry->next;
+        //  a waiter leaving a semaphore gives back the unit it took from the value
+        if (proc != NULL && proc->waitOn == &entry->waiters && waitQueueRemove(&entry->waiters, proc))
         {
-            //  clear semTable entry
-            procTable[procTableContains(semTable[index].waitingPid)].status = STATUS_READY;
-            memset(&semTable[index], 0, sizeof(semb_t));
-            semTabEntries--;
-            //  defrag semTable
-            semTabDefrag();
-            if (semTabEntries <= (semTabSize / 2))
+            (*entry->value)++;
+        }
+        /*  a parked semop gives back the units it counted as waiting for; any it was holding back
+            (the value was short of what it needed) go to the processes queued behind it  */
+        if (proc != NULL && proc->waitOn == &entry->semops && waitQueueRemove(&entry->semops, proc))
+        {
+            *entry->value += proc->waitKey;
+            for (uint32_t i = 0; i < proc->waitKey && semTableFree(entry) > 0 && semTableOffer(entry); i++)
             {
-                //  shrink semTable if it can be
-                semTabSize = semTabSize / 2;
-                semTable = realloc(semTable, semTabSize * sizeof(semb_t));
             }
-
-            index = semTabContains(sem);
         }
+        if (entry->owner == pid)
+        {
+            semTabDelete(entry);
+        }
+        entry = next;
+    }
+    //  any other wait (e.g., on a futex)
+    if (proc != NULL)
+    {
+        waitCancel(proc);
     }
     return;
 }
 
-//  deletes all entries with waitingPid = given PID (completely removes semaphore if owner = given PID)
-void semTableRemove(pid_t pid)
+#ifdef KERNEL_LOCK_STATS
+//  write a labelled integer to the console
+void semStatPut(char *label, uint32_t x)
 {
-    for (int i = 0; i < semTabSize; i++)
+    char string[12];
+    itoaLocal(string, x);
+    kputs(label, strlen(label));
+    kputs(string, strlen(string));
+}
+
+uint32_t semStatMicros(uint64_t ticks)
+{
+    return (uint32_t)((ticks * 1000000) / 24000000);
+}
+#endif
+
+//  print the n (at most SEM_STAT_RANKS) semaphores with the most time waited on them, most first (lockstat)
+void semTableStats(int n)
+{
+    kputs("---LOCK STATS:---\n", 18);
+#ifdef KERNEL_LOCK_STATS
+    semb_t *ranked[SEM_STAT_RANKS];
+    int length = 0;
+
+    n = (n <= 0 || n > SEM_STAT_RANKS) ? SEM_STAT_RANKS : n;
+    //  insertion into the n most waited on so far
+    for (semb_t *entry = semTable; entry != NULL; entry = entry->next)
     {
-        if (semTable[i].waitingPid == pid)
+        int i = (length < n) ? length++ : n;
+        while (i > 0 && ranked[i - 1]->stats.waitTicks < entry->stats.waitTicks)
         {
-            //  clear semTable entry
-            memset(&semTable[i], 0, sizeof(semb_t));
-            semTabEntries--;
-            //  defrag semTable
-            semTabDefrag();
-            if (semTabEntries <= (semTabSize / 2))
+            if (i < n)
             {
-                //  shrink semTable if it can be
-                semTabSize = semTabSize / 2;
-                semTable = realloc(semTable, semTabSize * sizeof(semb_t));
+                ranked[i] = ranked[i - 1];
             }
+            i--;
         }
-        else if (semTable[i].waitingPid == 0 && semTable[i].owner == pid)
+        if (i < n)
         {
-            //  clear semTable entry
-            memset(&semTable[i], 0, sizeof(semb_t));
-            semTabEntries--;
-            //  defrag semTable
-            semTabDefrag();
-            if (semTabEntries <= (semTabSize / 2))
+            ranked[i] = entry;
+        }
+    }
+
+    for (int r = 0; r < length; r++)
+    {
+        semstat_t *stats = &ranked[r]->stats;
+        sem_t *sem = (sem_t *)ranked[r]->value;
+        kputs("---", 3);
+        semStatPut(" sem ", ranked[r]->handle);
+        semStatPut(" owner ", ranked[r]->owner);
+        semStatPut(" acquired ", stats->acquired + sem->acquired);
+        semStatPut(" contended ", stats->contended);
+        semStatPut(" posts ", stats->posts);
+        semStatPut(" wait_us ", semStatMicros(stats->waitTicks));
+        semStatPut(" max_us ", semStatMicros(stats->waitMax));
+        kputs("\n---   top waiters (pid:waits:us)", 33);
+        for (int i = 0; i < SEM_STAT_PIDS; i++)
+        {
+            if (stats->top[i].waits != 0)
             {
-                //  shrink semTable if it can be
-                semTabSize = semTabSize / 2;
-                semTable = realloc(semTable, semTabSize * sizeof(semb_t));
+                semStatPut(" ", stats->top[i].pid);
+                semStatPut(":", stats->top[i].waits);
+                semStatPut(":", semStatMicros(stats->top[i].ticks));
             }
-            free(semTable[i].sem);
         }
+        kputs("\n", 1);
     }
-
+#else
+    kputs("---build with -DKERNEL_LOCK_STATS\n", 34);
+#endif
+    kputs("------------------\n", 19);
     return;
-}
\ No newline at end of file
+}
@@ -4,23 +4,65 @@
 #include "../hilevel/hilevel.h"
 #include "../../user/libc.h"
 #include "../processTables/processTable.h"
+#include "../memory/slab.h"
+#include "./waitQueue.h"
+#include "./handleTable.h"
 
+//  waiting processes tracked per semaphore by the lock profiler
+#define SEM_STAT_PIDS (4)
+//  most semaphores lockstat reports
+#define SEM_STAT_RANKS (16)
+
+/*  lock profile of a semaphore (built with -DKERNEL_LOCK_STATS), from the SYS_SEM_WAIT and
+    SYS_SEM_POST paths; sem_wait's user-space fast path counts its acquisitions in sem_t  */
 typedef struct
 {
-    sem_t sem;
-    pid_t waitingPid;
-    int owner;
+    uint32_t acquired;  // acquisitions through the kernel (immediate or after waiting)
+    uint32_t contended; // sem_waits that blocked
+    uint32_t posts;     // sem_posts that entered the kernel
+    uint64_t waitTicks; // total time blocked (24 MHz ticks)
+    uint32_t waitMax;
+    struct
+    {
+        pid_t pid;
+        uint32_t waits;
+        uint64_t ticks;
+    } top[SEM_STAT_PIDS]; // the processes that have waited longest
+} semstat_t;
+
+/*  kernel semaphore, named in user space by handle
+      -value is the sem_t.value word in user space: >= 0 is the count, < 0 is minus the number of
+       processes waiting; user space updates it with LDREX/STREX and only calls sem_wait/sem_post
+       while it would be/is < 0
+      -a semop blocked on it is parked in semops and counts as waiting for as many units as it needs
+       (pcb_t.waitKey), so posts still enter the kernel  */
+typedef struct semb
+{
+    int *value;
+    int handle;
+    pid_t owner;
+    wait_queue_t waiters; // processes blocked in sem_wait, in arrival order
+    wait_queue_t semops;  // processes blocked in semop until this semaphore can proceed
+#ifdef KERNEL_LOCK_STATS
+    semstat_t stats;
+#endif
+    struct semb *next;
 } semb_t;
 
 extern semb_t *semTable;
-extern int semTabSize;
 extern int semTabEntries;
 
-extern void semTableNotify(sem_t sem);
-extern void semTableAdd(sem_t sem, pid_t pid, pid_t owner);
-extern int semTabContains(sem_t sem);
-extern bool semTabDuplicate(sem_t sem, pid_t pid, pid_t owner);
-extern pid_t semGetOwner(sem_t sem);
+extern slab_cache_t semCache;
+
+extern void semTableInit();
+extern semb_t *semTableAdd(pid_t owner, int *value);
+extern semb_t *semTabContains(int handle);
+extern bool semTableNotify(semb_t *entry);
+extern void semTablePost(semb_t *entry);
+extern void semTableOp(ctx_t *ctx, sembuf_t *ops, int n);
+extern void semTabDelete(semb_t *entry);
 extern void semTableRemove(pid_t pid);
+extern void semTableWaiting(semb_t *entry);
+extern void semTableStats(int n);
 
 #endif
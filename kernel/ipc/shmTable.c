@@ -1,117 +1,177 @@
 #include "./shmTable.h"
 #include <stdlib.h>
+#include "../memory/buddy.h"
 
-shm_t *shmTable;
-int shmTabSize = 0;
+/*  Shared memory segments are page aligned blocks from the page allocator, used directly
+    by every process attached to them (there is no MMU, so the address is the same in all
+    of them): the kernel is only entered to open, attach or detach, never to read or write.
+    Segments are found by key in a chained hash table, and freed when the last process
+    detaches; SHM_PRIVATE segments are never found by key.  */
+shm_t *shmTable[SHM_BUCKETS];
 int shmTabEntries = 0;
 
-/*  makes sure all shmTable entries are adjacent 
-    O(n^2)  */
-void shmTabDefrag()
+//  shmTable entries
+slab_cache_t shmCache;
+
+//  creates the shared memory cache
+void shmTableInit()
 {
-    for (int i = 0; i < shmTabSize; i++)
-    {
-        if (shmTable[i].addr == 0)
-        {
-            for (int j = i + 1; j < shmTabSize; j++)
-            {
-                if (shmTable[j].addr != 0)
-                {
-                    memcpy(&shmTable[i], &shmTable[j], sizeof(shm_t)); // set procTable[i] to procTable[j]
-                    memset(&shmTable[j], 0, sizeof(shm_t));            // set procTable[j] to 0
-                    break;
-                }
-            }
-        }
-    }
+    memset(shmTable, 0, sizeof(shmTable));
+    slabCacheInit(&shmCache, "shm", sizeof(shm_t), sizeof(void *), NULL);
     return;
 }
 
-//  returns index of addr in the shmTable (-1 if not in shmTable)
-int shmTabContains(void *addr)
+//  the chain key hashes to
+shm_t **shmBucket(int key)
 {
-    for (int i = 0; i < shmTabSize; i++)
-    {
-        if (shmTable[i].addr == addr)
-        {
-            return i;
-        }
-    }
-    return -1;
+    uint32_t x = (uint32_t)key;
+    return &shmTable[(x ^ (x >> 5) ^ (x >> 10)) & (SHM_BUCKETS - 1)];
 }
 
-//  initialises shm_t entry in shmTable and initialises shmTable
-//    -dynamically resizing
-int shmTabInit(pid_t owner, size_t size)
+//  the bit for the process with the given PID in a segment's users (0 if it doesn't exist)
+uint32_t shmUserBit(pid_t pid)
 {
+    int slot = procTableContains(pid);
+    return (slot < 0 || slot >= 32) ? 0 : (1u << slot);
+}
 
-    //  if the process table is full, resize
-    if (shmTabEntries >= shmTabSize && shmTabSize > 0)
+//  allocates a zeroed, page aligned segment and adds its entry to the shmTable (NULL if out of memory or handles)
+shm_t *shmTabInit(pid_t owner, int key, size_t size)
+{
+    int order = pageOrder(size);
+    if (size == 0 || order < 0)
     {
-        shmTabSize = shmTabSize * 2;
-        shmTable = realloc(shmTable, shmTabSize * sizeof(shm_t));
+        return NULL;
     }
-    else
+    shm_t *entry = slabAlloc(&shmCache);
+    if (entry == NULL)
     {
-        shmTabDefrag();
+        return NULL;
     }
-    //  if this is the first entry, malloc
-    if (shmTabSize == 0)
+    entry->addr = page_alloc(order);
+    if (entry->addr == NULL)
     {
-        shmTable = malloc(sizeof(shm_t));
-        shmTabSize++;
+        slabFree(&shmCache, entry);
+        return NULL;
     }
+    entry->handle = handleAlloc(HANDLE_SHM, entry);
+    if (entry->handle < 0)
+    {
+        page_free(entry->addr);
+        slabFree(&shmCache, entry);
+        return NULL;
+    }
+    memset(entry->addr, 0, PAGE_SIZE << order);
+    entry->owner = owner;
+    entry->key = key;
+    entry->size = size;
+    entry->refs = 0;
+    entry->users = 0;
 
-    shmTable[shmTabEntries].addr = calloc(1, size);
-    shmTable[shmTabEntries].owner = owner;
-    shmTable[shmTabEntries].size = size;
-
+    shm_t **bucket = shmBucket(key);
+    entry->next = *bucket;
+    *bucket = entry;
     shmTabEntries++;
 
-    return shmTabEntries - 1;
+    return entry;
 }
 
-//  delete addr from the shmTable and shrink the shmTable if it has empty space
-void shmTabDelete(void *addr)
+//  unlinks entry from its chain and frees it and its segment
+void shmTabDelete(shm_t *entry)
 {
-    int index = shmTabContains(addr);
-    //  if process is in process table
-    if (index >= 0)
+    shm_t **link = shmBucket(entry->key);
+    while (*link != NULL && *link != entry)
+    {
+        link = &(*link)->next;
+    }
+    if (*link == entry)
     {
-        //  clear shmTable entry
-        memset(&shmTable[index], 0, sizeof(shm_t));
+        *link = entry->next;
+        handleFree(entry->handle);
+        page_free(entry->addr);
+        slabFree(&shmCache, entry);
         shmTabEntries--;
-        //  defrag shmTable
-        shmTabDefrag();
-        if (shmTabEntries <= (shmTabSize / 2))
+    }
+    return;
+}
+
+//  returns the segment handle names (NULL if it isn't a live segment) - O(1)
+shm_t *shmTabContains(int handle)
+{
+    return handleLookup(handle, HANDLE_SHM);
+}
+
+/*  the segment with the given key, attached to pid: created (size bytes) if there is none, or
+    if key is SHM_PRIVATE; NULL if out of memory, or an existing segment is smaller than size  */
+shm_t *shmTabOpen(pid_t pid, int key, size_t size)
+{
+    shm_t *entry = NULL;
+    if (key != SHM_PRIVATE)
+    {
+        for (entry = *shmBucket(key); entry != NULL && entry->key != key; entry = entry->next)
         {
-            //  shrink shmTable if it can be
-            shmTabSize = shmTabSize / 2;
-            shmTable = realloc(shmTable, shmTabSize * sizeof(shm_t));
         }
     }
-    return;
+    if (entry == NULL)
+    {
+        entry = shmTabInit(pid, key, size);
+    }
+    else if (size > entry->size)
+    {
+        return NULL;
+    }
+    if (entry != NULL)
+    {
+        shmTabAttach(entry, pid);
+    }
+    return entry;
 }
 
-//  delete shm with owner = given PID from the shmTable and shrink the shmTable if it has empty space
+//  attach the process with the given PID to a segment (once; attaching again is a no-op), returning its address
+void *shmTabAttach(shm_t *entry, pid_t pid)
+{
+    uint32_t bit = shmUserBit(pid);
+    if (bit == 0)
+    {
+        return NULL;
+    }
+    if (!(entry->users & bit))
+    {
+        entry->users |= bit;
+        entry->refs++;
+    }
+    return entry->addr;
+}
+
+//  detach the process with the given PID from a segment, freeing it on the last detach (-1 if it wasn't attached)
+int shmTabDetach(shm_t *entry, pid_t pid)
+{
+    uint32_t bit = shmUserBit(pid);
+    if (bit == 0 || !(entry->users & bit))
+    {
+        return -1;
+    }
+    entry->users &= ~bit;
+    entry->refs--;
+    if (entry->refs == 0)
+    {
+        shmTabDelete(entry);
+    }
+    return 0;
+}
+
+//  detach the process with the given PID from every segment (when it exits)
 void shmTabRemove(pid_t pid)
 {
-    for (int i = 0; i < shmTabSize; i++)
+    for (int i = 0; i < SHM_BUCKETS; i++)
     {
-        if (shmTable[i].owner == pid)
+        shm_t *entry = shmTable[i];
+        while (entry != NULL)
         {
-            free(shmTable[i].addr);
-            memset(&shmTable[i], 0, sizeof(shm_t));
-            shmTabEntries--;
-            //  defrag shmTable
-            shmTabDefrag();
-            if (shmTabEntries <= (shmTabSize / 2))
-            {
-                //  shrink shmTable if it can be
-                shmTabSize = shmTabSize / 2;
-                shmTable = realloc(shmTable, shmTabSize * sizeof(shm_t));
-            }
+            shm_t *next = entry->next;
+            shmTabDetach(entry, pid);
+            entry = next;
         }
     }
     return;
-}
\ No newline at end of file
+}
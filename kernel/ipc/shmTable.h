@@ -4,14 +4,22 @@
 #include "../hilevel/hilevel.h"
 #include "../../user/libc.h"
 #include "../processTables/processTable.h"
+#include "../memory/slab.h"
+#include "./handleTable.h"
 
-extern shm_t *shmTable;
-extern int shmTabSize;
+//  number of chains segment keys are hashed into (a power of 2)
+#define SHM_BUCKETS (32)
+
+extern shm_t *shmTable[SHM_BUCKETS];
 extern int shmTabEntries;
 
-extern int shmTabInit(pid_t owner, size_t size);
-extern void shmTabDelete(void *addr);
-extern int shmTabContains(void *addr);
+extern slab_cache_t shmCache;
+
+extern void shmTableInit();
+extern shm_t *shmTabOpen(pid_t pid, int key, size_t size);
+extern shm_t *shmTabContains(int handle);
+extern void *shmTabAttach(shm_t *entry, pid_t pid);
+extern int shmTabDetach(shm_t *entry, pid_t pid);
 extern void shmTabRemove(pid_t pid);
 
 #endif
@@ -0,0 +1,273 @@
+#include "./syncTable.h"
+#include <stdlib.h>
+
+//  singly linked list of every condition variable, barrier and reader-writer lock
+syncb_t *syncTable = NULL;
+int syncTabEntries = 0;
+
+slab_cache_t syncCache;
+
+//  handle type of each sync_type_t
+const handle_type_t syncHandleTypes[] = {HANDLE_COND, HANDLE_BARRIER, HANDLE_RWLOCK};
+
+//  objects start (and are freed) with no waiters or holders
+void syncCtor(void *obj)
+{
+    memset(obj, 0, sizeof(syncb_t));
+}
+
+//  creates the cache
+void syncTableInit()
+{
+    slabCacheInit(&syncCache, "sync", sizeof(syncb_t), sizeof(void *), &syncCtor);
+    return;
+}
+
+//  creates an object of the given type (parties is only used by barriers), returning NULL if out of memory or handles
+syncb_t *syncTableAdd(sync_type_t type, int parties, pid_t owner)
+{
+    syncb_t *entry = slabAlloc(&syncCache);
+    if (entry != NULL)
+    {
+        entry->handle = handleAlloc(syncHandleTypes[type], entry);
+        if (entry->handle < 0)
+        {
+            slabFree(&syncCache, entry);
+            return NULL;
+        }
+        entry->type = type;
+        entry->parties = parties;
+        entry->owner = owner;
+        entry->next = syncTable;
+        syncTable = entry;
+        syncTabEntries++;
+    }
+    return entry;
+}
+
+//  returns the object handle names (NULL if it isn't a live object of the given type) - O(1)
+syncb_t *syncTabContains(int handle, sync_type_t type)
+{
+    return handleLookup(handle, syncHandleTypes[type]);
+}
+
+//  unlinks and frees an object; any waiters are woken with -1
+void syncTabDelete(syncb_t *entry)
+{
+    syncb_t **link = &syncTable;
+    while (*link != NULL && *link != entry)
+    {
+        link = &(*link)->next;
+    }
+    if (*link == entry)
+    {
+        *link = entry->next;
+        handleFree(entry->handle);
+        waitWakeAll(&entry->waiters, -1);
+        waitWakeAll(&entry->writers, -1);
+        //  return the object to its constructed state before freeing
+        syncCtor(entry);
+        slabFree(&syncCache, entry);
+        syncTabEntries--;
+    }
+    return;
+}
+
+//  ----CONDITION VARIABLES----
+
+/*  release mutex (a user-space mutex_t) and block P_{current} on the condition, as one step
+      -r0 is set to 0 when signalled; cond_wait then re-locks the mutex in user space  */
+void syncCondWait(ctx_t *ctx, syncb_t *entry, mutex_t *mutex)
+{
+    //  unlock as mutex_unlock would (IRQs are masked, and CLREX fails any LDREX/STREX in flight)
+    int c = *mutex;
+    *mutex = 0;
+    if (c == 2)
+    {
+        futexWake((uint32_t)mutex, 1);
+    }
+    if (!waitBlock(ctx, &entry->waiters))
+    {
+        //  nothing else can run: return as a spurious wakeup (the caller re-checks its condition)
+        ctx->pc += 4;
+        ctx->gpr[0] = 0;
+    }
+    return;
+}
+
+//  wake the longest waiting process (or all), returning the number woken - O(1) for one
+int syncCondSignal(syncb_t *entry, bool all)
+{
+    int woken = entry->waiters.length;
+    if (all)
+    {
+        waitWakeAll(&entry->waiters, 0);
+        return woken;
+    }
+    return (waitWake(&entry->waiters, 0) != NULL) ? 1 : 0;
+}
+
+//  ----BARRIERS----
+
+/*  block P_{current} until parties processes have arrived
+      -the last to arrive releases the rest (each returning 0) and returns 1 itself  */
+void syncBarrierWait(ctx_t *ctx, syncb_t *entry)
+{
+    entry->count++;
+    if (entry->count >= entry->parties)
+    {
+        entry->count = 0;
+        waitWakeAll(&entry->waiters, 0);
+        ctx->gpr[0] = 1;
+        return;
+    }
+    if (!waitBlock(ctx, &entry->waiters))
+    {
+        //  nothing else can run: arrive again when retried
+        entry->count--;
+    }
+    return;
+}
+
+//  ----READER-WRITER LOCKS----
+
+//  the bit for proc in a lock's readers (0 if its slot has none)
+uint32_t syncReaderBit(pcb_t *proc)
+{
+    int slot = proc - procTable;
+    return (slot < 0 || slot >= 32) ? 0 : (1u << slot);
+}
+
+//  record proc as holding a read lock
+void syncReadGrant(syncb_t *entry, pcb_t *proc)
+{
+    entry->readers |= syncReaderBit(proc);
+    entry->count++;
+}
+
+/*  shared lock: granted unless a writer holds it or is waiting (so writers aren't starved)
+      -r0 is set to -1 if P_{current} already holds it for reading  */
+void syncReadLock(ctx_t *ctx, syncb_t *entry)
+{
+    uint32_t bit = syncReaderBit(currentProc);
+
+    if (bit == 0 || (entry->readers & bit))
+    {
+        ctx->gpr[0] = -1;
+        return;
+    }
+    if (entry->writer == NULL && entry->writers.length == 0)
+    {
+        syncReadGrant(entry, currentProc);
+        ctx->gpr[0] = 0;
+        return;
+    }
+    waitBlock(ctx, &entry->waiters);
+    return;
+}
+
+//  exclusive lock: granted if no reader or writer holds it
+void syncWriteLock(ctx_t *ctx, syncb_t *entry)
+{
+    if (entry->writer == NULL && entry->count == 0)
+    {
+        entry->writer = currentProc;
+        ctx->gpr[0] = 0;
+        return;
+    }
+    if (entry->writer == currentProc)
+    {
+        ctx->gpr[0] = -1;
+        return;
+    }
+    waitBlock(ctx, &entry->writers);
+    return;
+}
+
+//  hand the lock on: to the longest waiting writer once it is free, else (no writers waiting) to every waiting reader
+void syncGrant(syncb_t *entry)
+{
+    if (entry->writer != NULL)
+    {
+        return;
+    }
+    if (entry->count == 0)
+    {
+        entry->writer = waitWake(&entry->writers, 0);
+        if (entry->writer != NULL)
+        {
+            return;
+        }
+    }
+    if (entry->writers.length == 0)
+    {
+        pcb_t *reader;
+        while ((reader = waitWake(&entry->waiters, 0)) != NULL)
+        {
+            syncReadGrant(entry, reader);
+        }
+    }
+    return;
+}
+
+//  release proc's hold (write if it is the writer, else its read), returning -1 if proc doesn't hold the lock
+int syncUnlock(syncb_t *entry, pcb_t *proc)
+{
+    uint32_t bit = syncReaderBit(proc);
+
+    if (entry->writer == proc)
+    {
+        entry->writer = NULL;
+    }
+    else if (bit != 0 && (entry->readers & bit))
+    {
+        entry->readers &= ~bit;
+        entry->count--;
+    }
+    else
+    {
+        return -1;
+    }
+    syncGrant(entry);
+    return 0;
+}
+
+//  for the process with the given PID: stop waiting, release any lock it holds and destroy what it created
+void syncTableRemove(pid_t pid)
+{
+    int slot = procTableContains(pid);
+    pcb_t *proc = (slot >= 0) ? &procTable[slot] : NULL;
+
+    syncb_t *entry = syncTable;
+    while (entry != NULL)
+    {
+        syncb_t *next = entry->next;
+        if (proc != NULL)
+        {
+            if (waitQueueRemove(&entry->waiters, proc) && entry->type == SYNC_BARRIER)
+            {
+                entry->count--;
+            }
+            //  a writer leaving the queue may unblock the readers behind it
+            if (waitQueueRemove(&entry->writers, proc) || entry->writer == proc)
+            {
+                if (entry->writer == proc)
+                {
+                    entry->writer = NULL;
+                }
+                syncGrant(entry);
+            }
+            //  as may the last reader letting go (a no-op if proc holds no read lock)
+            if (entry->type == SYNC_RWLOCK)
+            {
+                syncUnlock(entry, proc);
+            }
+        }
+        if (entry->owner == pid)
+        {
+            syncTabDelete(entry);
+        }
+        entry = next;
+    }
+    return;
+}
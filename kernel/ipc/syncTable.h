@@ -0,0 +1,56 @@
+#ifndef __SYNCTABLE_H
+#define __SYNCTABLE_H
+
+#include "../hilevel/hilevel.h"
+#include "../../user/libc.h"
+#include "../processTables/processTable.h"
+#include "../memory/slab.h"
+#include "./waitQueue.h"
+#include "./futex.h"
+#include "./handleTable.h"
+
+typedef enum
+{
+    SYNC_COND,
+    SYNC_BARRIER,
+    SYNC_RWLOCK
+} sync_type_t;
+
+/*  condition variable, barrier or reader-writer lock (all blocking on waitQueue.c queues)
+      -cond:    waiters blocked in cond_wait
+      -barrier: waiters blocked until count reaches parties
+      -rwlock:  waiters are blocked readers, writers blocked writers; count is the number of
+                readers holding it and readers their procTable slots (bit i for slot i, each
+                holding it once), writer the process holding it for writing (NULL if none)  */
+typedef struct syncb
+{
+    sync_type_t type;
+    int handle;
+    pid_t owner; // destroyed when this process exits
+    wait_queue_t waiters;
+    wait_queue_t writers;
+    int count;
+    int parties;
+    uint32_t readers;
+    pcb_t *writer;
+    struct syncb *next;
+} syncb_t;
+
+extern syncb_t *syncTable;
+extern int syncTabEntries;
+
+extern slab_cache_t syncCache;
+
+extern void syncTableInit();
+extern syncb_t *syncTableAdd(sync_type_t type, int parties, pid_t owner);
+extern syncb_t *syncTabContains(int handle, sync_type_t type);
+extern void syncTabDelete(syncb_t *entry);
+extern void syncCondWait(ctx_t *ctx, syncb_t *entry, mutex_t *mutex);
+extern int syncCondSignal(syncb_t *entry, bool all);
+extern void syncBarrierWait(ctx_t *ctx, syncb_t *entry);
+extern void syncReadLock(ctx_t *ctx, syncb_t *entry);
+extern void syncWriteLock(ctx_t *ctx, syncb_t *entry);
+extern int syncUnlock(syncb_t *entry, pcb_t *proc);
+extern void syncTableRemove(pid_t pid);
+
+#endif
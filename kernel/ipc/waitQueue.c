@@ -0,0 +1,197 @@
+#include "./waitQueue.h"
+
+//  append proc to the tail of queue - O(1)
+void waitQueuePush(wait_queue_t *queue, pcb_t *proc)
+{
+    proc->waitNext = NULL;
+    proc->waitOn = queue;
+    if (queue->tail == NULL)
+    {
+        queue->head = proc;
+    }
+    else
+    {
+        queue->tail->waitNext = proc;
+    }
+    queue->tail = proc;
+    queue->length++;
+    return;
+}
+
+//  remove and return the head of queue (NULL if empty) - O(1)
+pcb_t *waitQueuePop(wait_queue_t *queue)
+{
+    pcb_t *proc = queue->head;
+    if (proc != NULL)
+    {
+        queue->head = proc->waitNext;
+        if (queue->head == NULL)
+        {
+            queue->tail = NULL;
+        }
+        proc->waitNext = NULL;
+        proc->waitOn = NULL;
+        queue->length--;
+    }
+    return proc;
+}
+
+//  remove proc from anywhere in queue, returning false if it wasn't there - O(n)
+bool waitQueueRemove(wait_queue_t *queue, pcb_t *proc)
+{
+    pcb_t *prev = NULL;
+    for (pcb_t *entry = queue->head; entry != NULL; entry = entry->waitNext)
+    {
+        if (entry == proc)
+        {
+            if (prev == NULL)
+            {
+                queue->head = proc->waitNext;
+            }
+            else
+            {
+                prev->waitNext = proc->waitNext;
+            }
+            if (queue->tail == proc)
+            {
+                queue->tail = prev;
+            }
+            proc->waitNext = NULL;
+            proc->waitOn = NULL;
+            queue->length--;
+            return true;
+        }
+        prev = entry;
+    }
+    return false;
+}
+
+/*  block P_{current} on queue and dispatch another process into ctx
+      -the caller must not touch ctx afterwards: it now belongs to the next process
+      -if no other process can run, P_{current} is left runnable with its pc wound back
+       onto the svc, so the system call is retried when it next resumes (returns false)  */
+bool waitBlock(ctx_t *ctx, wait_queue_t *queue)
+{
+    pcb_t *proc = currentProc;
+
+    proc->status = STATUS_WAITING;
+    removeFromMLFQ(proc->pid);
+    waitQueuePush(queue, proc);
+
+    if (!scheduleBlock(ctx))
+    {
+        waitQueueRemove(queue, proc);
+        scheduleWake(proc);
+        proc->status = STATUS_EXECUTING;
+        ctx->pc -= 4;
+        return false;
+    }
+    return true;
+}
+
+/*  block P_{current} on queue so that, when woken, it re-executes the system call with the
+    arguments left in its saved registers (the caller may update them to record progress)
+      -as waitBlock, returns false (the system call is retried) if no other process can run  */
+bool waitBlockRestart(ctx_t *ctx, wait_queue_t *queue)
+{
+    pcb_t *proc = currentProc;
+
+    ctx->pc -= 4;
+    proc->waitRestart = true;
+    if (!waitBlock(ctx, queue))
+    {
+        //  waitBlock has wound pc back itself
+        ctx->pc += 4;
+        proc->waitRestart = false;
+        return false;
+    }
+    return true;
+}
+
+//  make proc runnable with its blocking system call returning r (unless it is to be restarted)
+void waitResume(pcb_t *proc, uint32_t r)
+{
+    if (proc->waitRestart)
+    {
+        proc->waitRestart = false;
+    }
+    else
+    {
+        proc->ctx.gpr[0] = r;
+    }
+    scheduleWake(proc);
+    if (scheduleWoken == NULL)
+    {
+        scheduleWoken = proc;
+    }
+    return;
+}
+
+//  wake the head of queue, its blocking system call returning r - O(1)
+pcb_t *waitWake(wait_queue_t *queue, uint32_t r)
+{
+    pcb_t *proc = waitQueuePop(queue);
+    if (proc != NULL)
+    {
+        waitResume(proc, r);
+    }
+    return proc;
+}
+
+//  wake every process in queue, each returning r
+void waitWakeAll(wait_queue_t *queue, uint32_t r)
+{
+    while (waitWake(queue, r) != NULL)
+    {
+    }
+    return;
+}
+
+//  wake up to n processes in queue waiting with the given key (in arrival order), each returning r
+int waitWakeKey(wait_queue_t *queue, uint32_t key, int n, uint32_t r)
+{
+    int woken = 0;
+    pcb_t *entry = queue->head;
+    while (entry != NULL && woken < n)
+    {
+        pcb_t *next = entry->waitNext;
+        if (entry->waitKey == key)
+        {
+            waitQueueRemove(queue, entry);
+            waitResume(entry, r);
+            woken++;
+        }
+        entry = next;
+    }
+    return woken;
+}
+
+//  take proc out of whatever queue it is blocked on (when it is killed)
+void waitCancel(pcb_t *proc)
+{
+    if (proc->waitOn != NULL)
+    {
+        waitQueueRemove(proc->waitOn, proc);
+    }
+    return;
+}
+
+//  end every restartable wait in queue whose deadline has passed by now, its system call returning 0 (timed out)
+void waitExpire(wait_queue_t *queue, uint32_t now)
+{
+    pcb_t *proc = queue->head;
+    while (proc != NULL)
+    {
+        pcb_t *next = proc->waitNext;
+        if (proc->waitDeadline != 0 && (int32_t)(now - proc->waitDeadline) >= 0)
+        {
+            waitQueueRemove(queue, proc);
+            proc->waitDeadline = 0;
+            proc->ctx.pc += 4;
+            proc->waitRestart = false;
+            waitResume(proc, 0);
+        }
+        proc = next;
+    }
+    return;
+}
@@ -0,0 +1,30 @@
+#ifndef __WAITQUEUE_H
+#define __WAITQUEUE_H
+
+#include "../hilevel/hilevel.h"
+#include "../processTables/processTable.h"
+#include "../scheduling/scheduler.h"
+
+/*  FIFO of blocked processes, linked through pcb_t.waitNext (so blocking never allocates).
+    A blocked process is STATUS_WAITING and off the MLFQ; it is woken with the value
+    its blocking system call returns, written into its saved r0.  */
+typedef struct wait_queue
+{
+    pcb_t *head;
+    pcb_t *tail;
+    int length;
+} wait_queue_t;
+
+extern void waitQueuePush(wait_queue_t *queue, pcb_t *proc);
+extern pcb_t *waitQueuePop(wait_queue_t *queue);
+extern bool waitQueueRemove(wait_queue_t *queue, pcb_t *proc);
+extern bool waitBlock(ctx_t *ctx, wait_queue_t *queue);
+extern bool waitBlockRestart(ctx_t *ctx, wait_queue_t *queue);
+extern void waitResume(pcb_t *proc, uint32_t r);
+extern pcb_t *waitWake(wait_queue_t *queue, uint32_t r);
+extern void waitWakeAll(wait_queue_t *queue, uint32_t r);
+extern int waitWakeKey(wait_queue_t *queue, uint32_t key, int n, uint32_t r);
+extern void waitCancel(pcb_t *proc);
+extern void waitExpire(wait_queue_t *queue, uint32_t now);
+
+#endif
@@ -30,6 +30,7 @@ lolevel_handler_rst: bl    int_init                @ initialise interrupt vector
                      msr   spsr, r0                @ move     USR mode        CPSR
                      ldmia sp, { r0-r12, sp, lr }^ @ restore  USR mode registers
                      add   sp, sp, #60             @ update   SVC mode SP
+                     clrex                         @ clear    exclusive monitor (fail any USR mode ldrex/strex in flight)
                      movs  pc, lr                  @ return from interrupt
 
 lolevel_handler_irq: sub   lr, lr, #4              @ correct return address
@@ -45,6 +46,7 @@ lolevel_handler_irq: sub   lr, lr, #4              @ correct return address
                      msr   spsr, r0                @ move     USR mode        CPSR
                      ldmia sp, { r0-r12, sp, lr }^ @ restore  USR mode registers
                      add   sp, sp, #60             @ update   SVC mode SP
+                     clrex                         @ clear    exclusive monitor (fail any USR mode ldrex/strex in flight)
                      movs  pc, lr                  @ return from interrupt
 
 lolevel_handler_svc: sub   lr, lr, #0              @ correct return address
@@ -62,4 +64,5 @@ lolevel_handler_svc: sub   lr, lr, #0              @ correct return address
                      msr   spsr, r0                @ move     USR mode        CPSR
                      ldmia sp, { r0-r12, sp, lr }^ @ restore  USR mode registers
                      add   sp, sp, #60             @ update   SVC mode SP
+                     clrex                         @ clear    exclusive monitor (fail any USR mode ldrex/strex in flight)
                      movs  pc, lr                  @ return from interrupt
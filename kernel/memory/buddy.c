@@ -0,0 +1,210 @@
+#include "buddy.h"
+#include "kheap.h"
+#include <stdlib.h>
+#include "../../user/console.h"
+
+//  defined in image.ld: page frames run from the first 1 MiB boundary above the kernel image to the end of RAM
+extern uint32_t _pages_start;
+extern uint32_t _pages_end;
+
+//  frame info: the order of the block a frame heads, plus PAGE_INFO_FREE if that block is free
+#define PAGE_INFO_FREE (0x80)
+#define PAGE_INFO_ORDER (0x7F)
+
+uint8_t *pageBase;
+uint8_t *pageInfo;
+int pageFrames = 0;
+
+//  free list (doubly linked through the free blocks themselves) and free block count of every order
+page_block_t *pageFreeLists[PAGE_ORDER_MAX + 1];
+int pageFreeCounts[PAGE_ORDER_MAX + 1];
+
+//  frame index of addr
+int pageIndex(void *addr)
+{
+  return ((uint8_t *)addr - pageBase) / PAGE_SIZE;
+}
+
+//  address of frame index i
+page_block_t *pageAddr(int i)
+{
+  return (page_block_t *)(pageBase + (i * PAGE_SIZE));
+}
+
+//  push the block headed by frame i onto the free list of the given order
+void pagePush(int i, int order)
+{
+  page_block_t *block = pageAddr(i);
+  block->prev = NULL;
+  block->next = pageFreeLists[order];
+  if (block->next != NULL)
+  {
+    block->next->prev = block;
+  }
+  pageFreeLists[order] = block;
+  pageFreeCounts[order]++;
+  pageInfo[i] = PAGE_INFO_FREE | order;
+}
+
+//  unlink the (free) block headed by frame i from the free list of the given order
+void pageUnlink(int i, int order)
+{
+  page_block_t *block = pageAddr(i);
+  if (block->prev != NULL)
+  {
+    block->prev->next = block->next;
+  }
+  else
+  {
+    pageFreeLists[order] = block->next;
+  }
+  if (block->next != NULL)
+  {
+    block->next->prev = block->prev;
+  }
+  pageFreeCounts[order]--;
+  pageInfo[i] = order;
+}
+
+//  hand every frame between _pages_start and _pages_end to the allocator as the largest aligned blocks possible
+void pageInit()
+{
+  pageBase = (uint8_t *)(&_pages_start);
+  pageFrames = ((uint8_t *)(&_pages_end) - pageBase) / PAGE_SIZE;
+  pageInfo = kcalloc(pageFrames, sizeof(uint8_t));
+
+  for (int order = 0; order <= PAGE_ORDER_MAX; order++)
+  {
+    pageFreeLists[order] = NULL;
+    pageFreeCounts[order] = 0;
+  }
+
+  int i = 0;
+  while (i < pageFrames)
+  {
+    int order = PAGE_ORDER_MAX;
+    while ((i & ((1 << order) - 1)) != 0 || i + (1 << order) > pageFrames)
+    {
+      order--;
+    }
+    pagePush(i, order);
+    i += 1 << order;
+  }
+  return;
+}
+
+//  smallest order whose blocks hold size bytes (-1 if larger than the largest block)
+int pageOrder(size_t size)
+{
+  for (int order = 0; order <= PAGE_ORDER_MAX; order++)
+  {
+    if (size <= (PAGE_SIZE << order))
+    {
+      return order;
+    }
+  }
+  return -1;
+}
+
+/*  allocate a block of 2^order frames (aligned to its size), NULL if none are left
+    -splits the smallest free block that fits, O(PAGE_ORDER_MAX)  */
+void *page_alloc(int order)
+{
+  if (order < 0 || order > PAGE_ORDER_MAX)
+  {
+    return NULL;
+  }
+  int k = order;
+  while (k <= PAGE_ORDER_MAX && pageFreeLists[k] == NULL)
+  {
+    k++;
+  }
+  if (k > PAGE_ORDER_MAX)
+  {
+    return NULL;
+  }
+
+  int i = pageIndex(pageFreeLists[k]);
+  pageUnlink(i, k);
+  //  return the upper half of each split to the free lists
+  while (k > order)
+  {
+    k--;
+    pagePush(i + (1 << k), k);
+  }
+  pageInfo[i] = order;
+  return pageAddr(i);
+}
+
+/*  free a block returned by page_alloc
+    -merges with its buddy while the buddy is free and the same order, O(PAGE_ORDER_MAX)  */
+void page_free(void *addr)
+{
+  if (addr == NULL)
+  {
+    return;
+  }
+  int i = pageIndex(addr);
+  int order = pageInfo[i] & PAGE_INFO_ORDER;
+
+  while (order < PAGE_ORDER_MAX)
+  {
+    int buddy = i ^ (1 << order);
+    if (buddy + (1 << order) > pageFrames || pageInfo[buddy] != (PAGE_INFO_FREE | order))
+    {
+      break;
+    }
+    pageUnlink(buddy, order);
+    pageInfo[buddy] = 0;
+    if (buddy < i)
+    {
+      pageInfo[i] = 0;
+      i = buddy;
+    }
+    order++;
+  }
+  pagePush(i, order);
+  return;
+}
+
+//  number of free blocks of the given order
+int pageFreeCount(int order)
+{
+  if (order < 0 || order > PAGE_ORDER_MAX)
+  {
+    return 0;
+  }
+  return pageFreeCounts[order];
+}
+
+//  print the free block count of every order to the console
+void pageStats()
+{
+  char string[12];
+  int freeFrames = 0;
+
+  kputs("---PAGE FRAMES:---\n", 19);
+  for (int order = 0; order <= PAGE_ORDER_MAX; order++)
+  {
+    kputs("---order ", 9);
+    itoaLocal(string, order);
+    kputs(string, strlen(string));
+    kputs(" (", 2);
+    itoaLocal(string, (PAGE_SIZE << order) / 1024);
+    kputs(string, strlen(string));
+    kputs(" KiB) free ", 11);
+    itoaLocal(string, pageFreeCounts[order]);
+    kputs(string, strlen(string));
+    kputs("\n", 1);
+    freeFrames += pageFreeCounts[order] << order;
+  }
+  kputs("---free frames ", 15);
+  itoaLocal(string, freeFrames);
+  kputs(string, strlen(string));
+  kputs(" of ", 4);
+  itoaLocal(string, pageFrames);
+  kputs(string, strlen(string));
+  kputs("\n", 1);
+  kputs("------------------\n", 19);
+  return;
+}
@@ -0,0 +1,28 @@
+#ifndef __BUDDY_H
+#define __BUDDY_H
+
+#include "../hilevel/hilevel.h"
+
+//  length of a page frame
+#define PAGE_SIZE (0x00001000)
+//  largest block is 2^PAGE_ORDER_MAX frames (1 MiB)
+#define PAGE_ORDER_MAX (8)
+
+//  free block header (stored in the first frame of every free block)
+typedef struct page_block
+{
+    struct page_block *next;
+    struct page_block *prev;
+} page_block_t;
+
+extern int pageFrames;
+extern int pageFreeCounts[PAGE_ORDER_MAX + 1];
+
+extern void pageInit();
+extern void *page_alloc(int order);
+extern void page_free(void *addr);
+extern int pageOrder(size_t size);
+extern int pageFreeCount(int order);
+extern void pageStats();
+
+#endif
@@ -0,0 +1,282 @@
+#include "kheap.h"
+#include <malloc.h>
+#include "../../user/console.h"
+
+//  defined in image.ld: the region newlib's sbrk hands to malloc
+extern uint32_t _heap_start;
+extern uint32_t _heap_end;
+
+//  true iff. the processor is in IRQ mode
+bool kheapInIrq()
+{
+  uint32_t cpsr;
+
+  asm volatile("mrs %0, cpsr \n"
+               : "=r"(cpsr));
+
+  return (cpsr & CPSR_MODE) == CPSR_MODE_IRQ;
+}
+
+//  report x on UART0 then stop (at a breakpoint under launch-gdb, else in the abort vector)
+void kheapTrap(char *x)
+{
+  char *p = "\nKERNEL PANIC: ";
+  while (*p != '\x00')
+  {
+    PL011_putc(UART0, *p++, true);
+  }
+  while (*x != '\x00')
+  {
+    PL011_putc(UART0, *x++, true);
+  }
+  PL011_putc(UART0, '\n', true);
+
+  asm volatile("bkpt #0 \n");
+  while (1)
+  {
+  }
+}
+
+#ifdef KERNEL_ASSERT_IRQ_ALLOC
+
+struct _reent;
+
+//  newlib takes this lock on entry to every allocator call
+void __malloc_lock(struct _reent *reent)
+{
+  if (kheapInIrq())
+  {
+    kheapTrap("heap allocator entered in IRQ mode");
+  }
+}
+
+void __malloc_unlock(struct _reent *reent)
+{
+}
+
+#endif
+
+//  ----CALL-SITE STATS----
+
+//  prepended to every allocation made through the wrappers (8 bytes, so payloads stay 8-byte aligned)
+typedef struct
+{
+  int site;
+  size_t size;
+} kheap_tag_t;
+
+kheap_site_t kheapSites[KHEAP_SITES];
+int kheapSiteCount = 0;
+int kheapLive = 0;
+int kheapLiveBytes = 0;
+int kheapPeakBytes = 0;
+
+//  index of the entry for file:line, adding one if it's new
+int kheapSite(const char *file, int line)
+{
+  for (int i = 0; i < kheapSiteCount; i++)
+  {
+    if (kheapSites[i].line == line && 0 == strcmp(kheapSites[i].file, file))
+    {
+      return i;
+    }
+  }
+  if (kheapSiteCount == KHEAP_SITES)
+  {
+    return KHEAP_SITES - 1;
+  }
+  kheapSites[kheapSiteCount].file = file;
+  kheapSites[kheapSiteCount].line = line;
+  return kheapSiteCount++;
+}
+
+//  tag a block just obtained from newlib and count it against its site
+void *kheapTag(kheap_tag_t *tag, size_t size, const char *file, int line)
+{
+  if (tag == NULL)
+  {
+    return NULL;
+  }
+  kheap_site_t *site = &kheapSites[kheapSite(file, line)];
+
+  tag->site = site - kheapSites;
+  tag->size = size;
+  site->calls++;
+  site->bytes += size;
+  site->live++;
+  site->liveBytes += size;
+  kheapLive++;
+  kheapLiveBytes += size;
+  if (kheapLiveBytes > kheapPeakBytes)
+  {
+    kheapPeakBytes = kheapLiveBytes;
+  }
+  return tag + 1;
+}
+
+//  uncount the block behind x
+kheap_tag_t *kheapUntag(void *x)
+{
+  kheap_tag_t *tag = (kheap_tag_t *)x - 1;
+  kheap_site_t *site = &kheapSites[tag->site];
+
+  site->live--;
+  site->liveBytes -= tag->size;
+  kheapLive--;
+  kheapLiveBytes -= tag->size;
+  return tag;
+}
+
+void *kheapMalloc(size_t size, const char *file, int line)
+{
+  return kheapTag(malloc(sizeof(kheap_tag_t) + size), size, file, line);
+}
+
+void *kheapCalloc(size_t n, size_t size, const char *file, int line)
+{
+  return kheapTag(calloc(1, sizeof(kheap_tag_t) + (n * size)), n * size, file, line);
+}
+
+void *kheapRealloc(void *x, size_t size, const char *file, int line)
+{
+  if (x == NULL)
+  {
+    return kheapMalloc(size, file, line);
+  }
+  kheap_tag_t *resized = realloc((kheap_tag_t *)x - 1, sizeof(kheap_tag_t) + size);
+  if (resized == NULL)
+  {
+    return NULL;
+  }
+  //  the tag moves with the block: uncount the old size, then count the new one
+  kheapUntag(resized + 1);
+  return kheapTag(resized, size, file, line);
+}
+
+void kheapFree(void *x)
+{
+  if (x != NULL)
+  {
+    free(kheapUntag(x));
+  }
+}
+
+//  ----REPORT----
+
+void kheapPutField(char *label, int x)
+{
+  char string[12];
+  itoaLocal(string, x);
+  kputs(" ", 1);
+  kputs(label, strlen(label));
+  kputs(" ", 1);
+  kputs(string, strlen(string));
+}
+
+/*  Histogram the free chunks by walking the heap chunk by chunk. This follows the
+    layout of newlib's (dlmalloc-derived) allocator: the first chunk sits at the
+    8-byte aligned start of the region, each chunk starts {prev_size, size} where
+    bit 0 of size is set iff. the previous chunk is in use, and the last chunk (top)
+    runs to the break. The walk stops early if a size doesn't fit that layout.  */
+void kheapHistogram(int *counts, int *bytes, int *largest, int *top)
+{
+  uint8_t *start = (uint8_t *)(((uint32_t)&_heap_start + 7) & ~7);
+  uint8_t *end = start + mallinfo().arena;
+
+  for (uint8_t *chunk = start; chunk + (2 * sizeof(size_t)) <= end;)
+  {
+    size_t size = ((size_t *)chunk)[1] & ~0x3;
+    if (size < (4 * sizeof(size_t)) || chunk + size > end)
+    {
+      break;
+    }
+    uint8_t *next = chunk + size;
+    if (next + (2 * sizeof(size_t)) > end)
+    {
+      *top = size;
+      break;
+    }
+    if (!(((size_t *)next)[1] & 0x1))
+    {
+      int bucket = 0;
+      while (bucket < (KHEAP_BUCKETS - 1) && size >= (32 << bucket))
+      {
+        bucket++;
+      }
+      counts[bucket]++;
+      bytes[bucket] += size;
+      if ((int)size > *largest)
+      {
+        *largest = size;
+      }
+    }
+    chunk = next;
+  }
+}
+
+//  print heap totals, the free chunk histogram and (if built in) the call-site table to the console
+void kheapStats()
+{
+  struct mallinfo info = mallinfo();
+  int counts[KHEAP_BUCKETS] = {0};
+  int bytes[KHEAP_BUCKETS] = {0};
+  int largest = 0;
+  int top = 0;
+  int freeBytes = 0;
+
+  kheapHistogram(counts, bytes, &largest, &top);
+
+  kputs("---KERNEL HEAP:---\n", 19);
+  kputs("---", 3);
+  kheapPutField("region", (uint8_t *)&_heap_end - (uint8_t *)&_heap_start);
+  kheapPutField("arena", info.arena);
+  kheapPutField("used", info.uordblks);
+  kheapPutField("free", info.fordblks);
+  kheapPutField("top", top);
+  kputs("\n", 1);
+
+  kputs("---FREE CHUNKS:---\n", 19);
+  for (int i = 0; i < KHEAP_BUCKETS; i++)
+  {
+    if (counts[i] == 0)
+    {
+      continue;
+    }
+    freeBytes += bytes[i];
+    kputs("---", 3);
+    kheapPutField(i == (KHEAP_BUCKETS - 1) ? ">=" : "<", 32 << i);
+    kheapPutField("chunks", counts[i]);
+    kheapPutField("bytes", bytes[i]);
+    kputs("\n", 1);
+  }
+  //  fragmentation: share of the free bytes (outside top) not in the largest free chunk
+  kputs("---", 3);
+  kheapPutField("largest", largest);
+  kheapPutField("frag%", freeBytes == 0 ? 0 : ((freeBytes - largest) * 100) / freeBytes);
+  kputs("\n", 1);
+
+#ifdef KERNEL_HEAP_STATS
+  kputs("---CALL SITES:---\n", 18);
+  kputs("---", 3);
+  kheapPutField("live", kheapLive);
+  kheapPutField("bytes", kheapLiveBytes);
+  kheapPutField("peak", kheapPeakBytes);
+  kputs("\n", 1);
+  for (int i = 0; i < kheapSiteCount; i++)
+  {
+    kputs("---", 3);
+    kputs((char *)kheapSites[i].file, strlen(kheapSites[i].file));
+    kputs(":", 1);
+    kheapPutField("line", kheapSites[i].line);
+    kheapPutField("calls", kheapSites[i].calls);
+    kheapPutField("bytes", kheapSites[i].bytes);
+    kheapPutField("live", kheapSites[i].live);
+    kheapPutField("liveBytes", kheapSites[i].liveBytes);
+    kputs("\n", 1);
+  }
+#else
+  kputs("---call sites: build with -DKERNEL_HEAP_STATS\n", 46);
+#endif
+  kputs("------------------\n", 19);
+  return;
+}
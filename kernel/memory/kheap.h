@@ -0,0 +1,56 @@
+#ifndef __KHEAP_H
+#define __KHEAP_H
+
+#include "../hilevel/hilevel.h"
+
+//  CPSR mode field and the IRQ mode encoding
+#define CPSR_MODE (0x1F)
+#define CPSR_MODE_IRQ (0x12)
+
+/*  Building with -DKERNEL_ASSERT_IRQ_ALLOC (see PROJECT_FLAGS in the Makefile) hooks
+    newlib's allocator lock so any malloc/calloc/realloc/free/memalign entered while the
+    processor is in IRQ mode (i.e., below hilevel_handler_irq) traps via kheapTrap.  */
+
+extern bool kheapInIrq();
+extern void kheapTrap(char *x);
+
+/*  Kernel code allocates through kmalloc/kcalloc/krealloc/kfree. Building with
+    -DKERNEL_HEAP_STATS makes these record calls and bytes against their call-site
+    (file:line), plus live objects and a high-water mark; otherwise they are plain
+    newlib calls. memstat (kheapStats) always reports the heap totals and a histogram
+    of the free chunks, and adds the per-site table when stats are built in.  */
+
+//  call-sites tracked (allocations from further sites are counted under the last)
+#define KHEAP_SITES (32)
+//  histogram buckets: free chunks of [2^(i+4), 2^(i+5)) bytes, the last open-ended
+#define KHEAP_BUCKETS (16)
+
+typedef struct
+{
+  const char *file;
+  int line;
+  int calls;     // allocations made here
+  int bytes;     // bytes requested here in total
+  int live;      // objects from here not yet freed
+  int liveBytes; // bytes from here not yet freed
+} kheap_site_t;
+
+#ifdef KERNEL_HEAP_STATS
+#define kmalloc(size) kheapMalloc(size, __FILE__, __LINE__)
+#define kcalloc(n, size) kheapCalloc(n, size, __FILE__, __LINE__)
+#define krealloc(x, size) kheapRealloc(x, size, __FILE__, __LINE__)
+#define kfree(x) kheapFree(x)
+#else
+#define kmalloc(size) malloc(size)
+#define kcalloc(n, size) calloc(n, size)
+#define krealloc(x, size) realloc(x, size)
+#define kfree(x) free(x)
+#endif
+
+extern void *kheapMalloc(size_t size, const char *file, int line);
+extern void *kheapCalloc(size_t n, size_t size, const char *file, int line);
+extern void *kheapRealloc(void *x, size_t size, const char *file, int line);
+extern void kheapFree(void *x);
+extern void kheapStats();
+
+#endif
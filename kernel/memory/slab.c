@@ -0,0 +1,144 @@
+#include "slab.h"
+#include <stdlib.h>
+#include "buddy.h"
+#include "../../user/console.h"
+
+//  every initialised cache (walked by slabStats)
+slab_cache_t *slabCaches = NULL;
+
+//  round x up to a multiple of a (a is a power of 2)
+size_t slabRound(size_t x, size_t a)
+{
+  return (x + a - 1) & ~(a - 1);
+}
+
+//  free list link of an object (stored after the object so constructed state survives a free)
+void **slabLink(slab_cache_t *cache, void *obj)
+{
+  return (void **)((uint8_t *)obj + cache->slotSize - sizeof(void *));
+}
+
+//  initialise an (empty) cache of objects of the given size and register it for slabStats
+void slabCacheInit(slab_cache_t *cache, const char *name, size_t size, size_t align, slab_ctor_t ctor)
+{
+  if (align < sizeof(void *))
+  {
+    align = sizeof(void *);
+  }
+  cache->name = name;
+  cache->size = size;
+  cache->align = align;
+  cache->slotSize = slabRound(slabRound(size, sizeof(void *)) + sizeof(void *), align);
+  cache->ctor = ctor;
+  cache->freeList = NULL;
+  cache->slabs = NULL;
+  cache->slabCount = 0;
+  cache->objsTotal = 0;
+  cache->objsInUse = 0;
+  cache->objsPeak = 0;
+  cache->next = slabCaches;
+  slabCaches = cache;
+  return;
+}
+
+/*  carve a new slab (one page frame) into objects, construct them and push them onto the free list
+    -the only place a cache touches the page allocator  */
+bool slabCacheGrow(slab_cache_t *cache)
+{
+  uint8_t *block = page_alloc(pageOrder(SLAB_SIZE));
+  if (block == NULL)
+  {
+    return false;
+  }
+  slab_t *slab = (slab_t *)block;
+  slab->next = cache->slabs;
+  cache->slabs = slab;
+  cache->slabCount++;
+
+  for (uint8_t *obj = block + slabRound(sizeof(slab_t), cache->align); obj + cache->slotSize <= block + SLAB_SIZE; obj += cache->slotSize)
+  {
+    if (cache->ctor != NULL)
+    {
+      cache->ctor(obj);
+    }
+    *slabLink(cache, obj) = cache->freeList;
+    cache->freeList = obj;
+    cache->objsTotal++;
+  }
+  return true;
+}
+
+//  grow the cache until at least n objects are free (so later allocations never grow it)
+void slabCacheReserve(slab_cache_t *cache, int n)
+{
+  while (cache->objsTotal - cache->objsInUse < n)
+  {
+    if (!slabCacheGrow(cache))
+    {
+      return;
+    }
+  }
+  return;
+}
+
+//  pop a constructed object from the cache (NULL if the cache can't grow)
+//    O(1)
+void *slabAlloc(slab_cache_t *cache)
+{
+  if (cache->freeList == NULL && !slabCacheGrow(cache))
+  {
+    return NULL;
+  }
+  void *obj = cache->freeList;
+  cache->freeList = *slabLink(cache, obj);
+  cache->objsInUse++;
+  if (cache->objsInUse > cache->objsPeak)
+  {
+    cache->objsPeak = cache->objsInUse;
+  }
+  return obj;
+}
+
+//  push an object (which must be back in its constructed state) onto the free list
+//    O(1)
+void slabFree(slab_cache_t *cache, void *obj)
+{
+  if (obj != NULL)
+  {
+    *slabLink(cache, obj) = cache->freeList;
+    cache->freeList = obj;
+    cache->objsInUse--;
+  }
+  return;
+}
+
+//  print " <label> <x>" to the console
+void slabPutField(char *label, int x)
+{
+  char string[12];
+  itoaLocal(string, x);
+  kputs(" ", 1);
+  kputs(label, strlen(label));
+  kputs(" ", 1);
+  kputs(string, strlen(string));
+}
+
+//  print the usage of every registered cache to the console
+void slabStats()
+{
+  kputs("---SLAB CACHES:---\n", 19);
+  for (slab_cache_t *cache = slabCaches; cache != NULL; cache = cache->next)
+  {
+    kputs("---", 3);
+    kputs((char *)cache->name, strlen(cache->name));
+    slabPutField("size", cache->size);
+    slabPutField("slot", cache->slotSize);
+    slabPutField("slabs", cache->slabCount);
+    slabPutField("total", cache->objsTotal);
+    slabPutField("used", cache->objsInUse);
+    slabPutField("peak", cache->objsPeak);
+    kputs("\n", 1);
+  }
+  kputs("------------------\n", 19);
+  return;
+}
@@ -0,0 +1,42 @@
+#ifndef __SLAB_H
+#define __SLAB_H
+
+#include "../hilevel/hilevel.h"
+
+//  length of a Cortex-A8 cache line: objects in aligned caches start on (and are padded to) a line
+#define SLAB_ALIGN (64)
+//  length of the block each slab is carved from (also its alignment)
+#define SLAB_SIZE (0x00001000)
+
+//  constructor run once on every object when its slab is carved (objects are freed back in constructed state)
+typedef void (*slab_ctor_t)(void *obj);
+
+typedef struct slab
+{
+    struct slab *next; // next slab in the owning cache
+} slab_t;
+
+typedef struct slab_cache
+{
+    const char *name;
+    size_t size;     // object size requested
+    size_t slotSize; // object size after padding (object + free list link, rounded to align)
+    size_t align;
+    slab_ctor_t ctor;
+    void *freeList; // first free object (links live at the end of each slot)
+    slab_t *slabs;
+    int slabCount;
+    int objsTotal;
+    int objsInUse;
+    int objsPeak;
+    struct slab_cache *next; // next registered cache (for slabStats)
+} slab_cache_t;
+
+extern void slabCacheInit(slab_cache_t *cache, const char *name, size_t size, size_t align, slab_ctor_t ctor);
+extern bool slabCacheGrow(slab_cache_t *cache);
+extern void slabCacheReserve(slab_cache_t *cache, int n);
+extern void *slabAlloc(slab_cache_t *cache);
+extern void slabFree(slab_cache_t *cache, void *obj);
+extern void slabStats();
+
+#endif
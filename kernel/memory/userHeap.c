@@ -0,0 +1,67 @@
+#include "userHeap.h"
+
+/*  allocates the heap of a process on first use
+    -the base is published through TPIDRURO so user space can find its allocator state without a syscall  */
+bool userHeapInit(pcb_t *proc)
+{
+  if (proc->heap == 0)
+  {
+    uint8_t *heap = page_alloc(PAGE_ORDER_MAX);
+    if (heap == NULL)
+    {
+      return false;
+    }
+    proc->heap = (uint32_t)heap;
+    proc->brk = proc->heap;
+    proc->tls = proc->heap;
+  }
+  return true;
+}
+
+//  sets the program break of a process to addr (0 on success, -1 if outside the heap)
+int userHeapBrk(pcb_t *proc, uint32_t addr)
+{
+  if (!userHeapInit(proc) || addr < proc->heap || addr > proc->heap + USER_HEAP_SIZE)
+  {
+    return -1;
+  }
+  proc->brk = addr;
+  return 0;
+}
+
+//  moves the program break of a process by incr bytes, returning the previous break (-1 if outside the heap)
+uint32_t userHeapSbrk(pcb_t *proc, int incr)
+{
+  if (!userHeapInit(proc))
+  {
+    return (uint32_t)-1;
+  }
+  uint32_t prev = proc->brk;
+  if (userHeapBrk(proc, prev + incr) < 0)
+  {
+    return (uint32_t)-1;
+  }
+  return prev;
+}
+
+//  loads TPIDRURO with the heap base of a process (on dispatch, or after its heap is created)
+void userHeapPublish(pcb_t *proc)
+{
+  asm volatile("mcr p15, 0, %0, c13, c0, 3 \n" // write TPIDRURO
+               :
+               : "r"(proc->tls));
+  return;
+}
+
+//  returns the heap of a process to the page allocator (on exec/exit)
+void userHeapFree(pcb_t *proc)
+{
+  if (proc->heap != 0)
+  {
+    page_free((void *)proc->heap);
+  }
+  proc->heap = 0;
+  proc->brk = 0;
+  proc->tls = 0;
+  return;
+}
@@ -0,0 +1,15 @@
+#ifndef __USERHEAP_H
+#define __USERHEAP_H
+
+#include "../hilevel/hilevel.h"
+#include "buddy.h"
+
+//  every process heap is one (lazily allocated) maximum order block
+#define USER_HEAP_SIZE (PAGE_SIZE << PAGE_ORDER_MAX)
+
+extern int userHeapBrk(pcb_t *proc, uint32_t addr);
+extern uint32_t userHeapSbrk(pcb_t *proc, int incr);
+extern void userHeapFree(pcb_t *proc);
+extern void userHeapPublish(pcb_t *proc);
+
+#endif
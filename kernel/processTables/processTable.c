@@ -6,10 +6,15 @@
  */
 #include "processTable.h"
 #include <stdlib.h>
+#include "../memory/buddy.h"
+#include "../memory/kheap.h"
+#include "../memory/userHeap.h"
+#include "../io/fdTable.h"
+#include "../io/ioRing.h"
 
 pcb_t *currentProc = NULL;
 pcb_t *procTable;
-int procTabSize = 1;
+int procTabSize = 0;
 
 //  number of processes in the procTable
 int PROCS = 0;
@@ -18,161 +23,193 @@ int PROCS_ACTIVE = 0;
 //  maximum number of procTable entries
 int MAX_PROCS = 32;
 
-/*  makes sure all process table entries are adjacent 
-      starting at procTable[1] as procTable[0] is reserved for the console.
-    
-    O(n^2)  */
-void procDefrag()
+/*  allocates the procTable once, at boot, with MAX_PROCS slots
+      -slot 0 is reserved for the console (PID -1), every other process has PID = slot
+      -slots never move or resize, so PCB pointers stay valid and nothing here allocates after boot  */
+void procTableInit()
 {
+  procTabSize = MAX_PROCS;
+  procTable = kcalloc(procTabSize, sizeof(pcb_t));
   for (int i = 0; i < procTabSize; i++)
+  {
+    procTable[i].status = STATUS_INVALID;
+  }
+  return;
+}
+
+//  returns the first free slot (not the console's), -1 if the procTable is full
+int procSlot()
+{
+  for (int i = 1; i < procTabSize; i++)
   {
     if (procTable[i].pid == 0)
     {
-      for (int j = i + 1; j < procTabSize; j++)
-      {
-        if (procTable[j].pid != 0)
-        {
-          memcpy(&procTable[i], &procTable[j], sizeof(pcb_t)); // set procTable[i] to procTable[j]
-          memset(&procTable[j], 0, sizeof(pcb_t));             // set procTable[j] to 0
-          break;
-        }
-      }
+      return i;
     }
   }
-  return;
+  return -1;
 }
 
 //  returns index of PID in the procTable (-1 if not in procTable)
+//    O(1)
 int procTableContains(pid_t pid)
 {
-  for (int i = 0; i < procTabSize; i++)
+  if (pid == -1)
   {
-    if (procTable[i].pid == pid)
-    {
-      return i;
-    }
+    return (procTabSize > 0 && procTable[0].pid == -1) ? 0 : -1;
+  }
+  if (pid > 0 && pid < procTabSize && procTable[pid].pid == pid)
+  {
+    return pid;
   }
   return -1;
 }
 
 //  makes a fork (exact copy inc. context) of a process
-//  MAKE CHECK FOR PID = -1 AS IT IS RETURNING PID -1 FOR CONSOLE
 int procCopy(pcb_t *parentProc, ctx_t *ctx)
 {
-  //parentProc->status = STATUS_WAITING;
-  //  if the process table is full, resize
-  if (PROCS >= procTabSize && PROCS < MAX_PROCS)
+  int slot = procSlot();
+  if (slot < 0)
   {
-    procTabSize = procTabSize * 2;
-    procTable = realloc(procTable, procTabSize * sizeof(pcb_t));
+    return -1;
   }
+  //  the child's stack comes from the page allocator
+  uint8_t *stack = page_alloc(pageOrder(STACK_SIZE));
+  if (stack == NULL)
+  {
+    return -1;
+  }
+  pcb_t *child = &procTable[slot];
   //  copy PCB
-  memcpy(&procTable[PROCS], parentProc, sizeof(pcb_t));
+  memcpy(child, parentProc, sizeof(pcb_t));
   //  set new PID
-  procTable[PROCS].pid = PROCS;
-  //  calculate new TOS for new stack
-  procTable[PROCS].tos = procTable[0].tos - (PROCS * 0x00001000);
-  //  copy stack // - 0x00001000
-  memcpy((uint32_t *)procTable[PROCS].tos - 0x00001000, (uint32_t *)parentProc->tos - 0x00001000, (uint32_t)0x00001000);
-  memcpy(&procTable[PROCS].ctx, &parentProc->ctx, sizeof(ctx_t));
+  child->pid = slot;
+  //  set TOS of the new stack
+  child->tos = (uint32_t)(stack + STACK_SIZE);
+  //  copy the used part of the parent's stack
+  uint32_t used = parentProc->tos - ctx->sp;
+  if (used > STACK_SIZE)
+  {
+    used = STACK_SIZE;
+  }
+  memcpy((uint8_t *)child->tos - used, (uint8_t *)ctx->sp, used);
+  memcpy(&child->ctx, &parentProc->ctx, sizeof(ctx_t));
   //  clear GPR
   //  return 0 in child (forked process)
-  procTable[PROCS].ctx.sp = procTable[PROCS].tos - (procTable[PROCS].tos - ctx->sp);
-  procTable[PROCS].ctx.pc = ctx->pc;
-  procTable[PROCS].ctx.gpr[0] = 0;
-  procTable[PROCS].priority = 1;
+  child->ctx.sp = child->tos - used;
+  child->ctx.pc = ctx->pc;
+  child->ctx.gpr[0] = 0;
+  child->priority = 1;
+  //  nothing lent to the parent (it holds the mutexes) or its waits carry over to the child
+  child->inherited = 0;
+  child->basePriority = 0;
+  child->waitNext = NULL;
+  child->waitOn = NULL;
+  child->waitKey = 0;
+  child->waitRestart = false;
+  child->waitDeadline = 0;
+  child->handoff = false;
+  //  without an MMU the parent's heap can't be duplicated, so the child starts with none
+  child->heap = 0;
+  child->brk = 0;
+  child->tls = 0;
+  child->ctx.cpsr = 0x50;
+  //  the child shares the parent's open files
+  fdFork(child);
   PROCS++;
-  procTable[PROCS - 1].ctx.cpsr = 0x50;
-  return procTable[PROCS - 1].pid;
+  return child->pid;
 }
 
-//  initialises PCB entry in procTable and initialises procTable
-//    -dynamically resizing
+//  initialises a PCB entry in the procTable (the first call creates the console), returns its PID (-1 if full)
 int procInit(void *mainFunc)
 {
-  //  if the process table is full, resize
-  if (PROCS >= procTabSize && PROCS < MAX_PROCS)
+  int slot = (PROCS == 0) ? 0 : procSlot();
+  if (slot < 0)
   {
-    procTabSize = procTabSize * 2;
-    procTable = realloc(procTable, procTabSize * sizeof(pcb_t));
+    return -1;
   }
-  //  if this is the first entry, malloc
-  else if (PROCS == 0)
-  {
-    procTable = malloc(procTabSize * sizeof(pcb_t));
-  }
-
-  procTable[PROCS].status = STATUS_CREATED;
 
-  // PID is -1 for console.c, 1 for first process and incremented for every subsequent process
-  if (PROCS == 0)
+  //  every process but the console gets its stack from the page allocator
+  pcb_t *proc = &procTable[slot];
+  if (slot == 0)
   {
-    procTable[PROCS].pid = -1;
-  }
-  else if (PROCS == 1)
-  {
-    procTable[PROCS].pid = 1;
+    proc->pid = -1;
+    proc->tos = (uint32_t)(&tos_user);
   }
   else
   {
-    procTable[PROCS].pid = PROCS;
-  }
-
-  if (PROCS == 0)
-  { //  set TOS, pc as entrypoint as SP as TOS
-    procTable[PROCS].tos = (uint32_t)(&tos_user);
-    procTable[PROCS].ctx.pc = (uint32_t)(mainFunc);
-    procTable[PROCS].ctx.sp = procTable[0].tos;
-  }
-
-  if (PROCS != 0)
-  {
-    procTable[PROCS].ctx.pc = (uint32_t)(mainFunc);
-    procTable[PROCS].tos = procTable[0].tos - (PROCS * 0x00001000);
-    procTable[PROCS].ctx.sp = procTable[PROCS].tos;
+    uint8_t *stack = page_alloc(pageOrder(STACK_SIZE));
+    if (stack == NULL)
+    {
+      return -1;
+    }
+    proc->pid = slot;
+    proc->tos = (uint32_t)(stack + STACK_SIZE);
   }
 
-  procTable[PROCS].priority = 1;
-  procTable[PROCS].status = STATUS_READY;
+  proc->status = STATUS_CREATED;
+  proc->heap = 0;
+  proc->brk = 0;
+  proc->tls = 0;
+  fdStd(proc);
+  procRestart(proc, mainFunc);
   PROCS++;
-  procTable[PROCS - 1].ctx.cpsr = 0x50;
-  return procTable[PROCS - 1].pid;
+  return proc->pid;
+}
+
+//  restarts a process at mainFunc on its existing stack (used by procInit, procExec and the scheduler)
+//    -never allocates, so it is safe from schedule()
+void procRestart(pcb_t *proc, void *mainFunc)
+{
+  memset(&proc->ctx, 0, sizeof(ctx_t));
+  proc->entry = (uint32_t)mainFunc;
+  proc->ctx.pc = (uint32_t)mainFunc;
+  proc->ctx.sp = proc->tos;
+  proc->ctx.cpsr = 0x50;
+  proc->priority = 1;
+  proc->waitNext = NULL;
+  proc->waitOn = NULL;
+  proc->waitKey = 0;
+  proc->waitRestart = false;
+  proc->waitDeadline = 0;
+  proc->handoff = false;
+  proc->inherited = 0;
+  proc->basePriority = 0;
+  proc->status = STATUS_READY;
+  return;
 }
 
-//  executes next available procTable entry (fork of previous) and returns it's PID
-int procExec(void *mainFunc)
+//  replaces the image of a process (the child of a fork) with mainFunc and returns it's PID
+int procExec(pcb_t *proc, void *mainFunc)
 {
-  //  clear ctx
-  memset(&procTable[PROCS - 1].ctx, 0, sizeof(procTable[0].ctx));
+  //  unregister any I/O ring first: it (and the buffers of its operations) lives in the old image
+  ioSetup(proc, NULL);
+  //  clear heap
+  userHeapFree(proc);
   //  clear stack to prevent security issues
-  memset((uint32_t *)procTable[PROCS - 1].tos - 0x00001000, 0, (uint32_t)0x00001000);
-  //  set PC to entrypoint of program
-  procTable[PROCS - 1].ctx.pc = (uint32_t)mainFunc;
-  procTable[PROCS - 1].ctx.sp = procTable[PROCS - 1].tos;
-  procTable[PROCS - 1].priority = 1;
-  procTable[PROCS - 1].ctx.cpsr = 0x50;
-  return procTable[PROCS - 1].pid;
+  memset((uint8_t *)proc->tos - STACK_SIZE, 0, STACK_SIZE);
+  //  clear ctx and set PC to entrypoint of program
+  procRestart(proc, mainFunc);
+  return proc->pid;
 }
 
-//  delete PID from the procTable and shrink the procTable if it has empty space
+//  delete PID from the procTable, freeing its slot
 void procDelete(pid_t pid)
 {
   int position = procTableContains(pid);
   //  if process is in process table
   if (position >= 0)
   {
+    //  return the stack to the page allocator (the console's lives in image.ld)
+    if (procTable[position].pid != -1)
+    {
+      page_free((uint8_t *)procTable[position].tos - STACK_SIZE);
+    }
+    userHeapFree(&procTable[position]);
     //  clear procTable entry
     memset(&procTable[position], 0, sizeof(pcb_t));
     procTable[position].status = STATUS_TERMINATED;
     PROCS--;
-    //  defrag process table
-    procDefrag();
-    if (PROCS <= (procTabSize / 2))
-    {
-      //  shrink process table if it can be
-      procTabSize = procTabSize / 2;
-      procTable = realloc(procTable, procTabSize * sizeof(pcb_t));
-    }
   }
   return;
 }
\ No newline at end of file
@@ -3,17 +3,22 @@
 
 #include "../hilevel/hilevel.h"
 
+//  length of every user process stack (the console's is allocated in image.ld)
+#define STACK_SIZE (0x00001000)
+
 extern pcb_t *procTable;
 extern pcb_t *currentProc;
 extern int procTabSize;
 
+extern void procTableInit();
 extern int procInit(void *mainFunc);
+extern void procRestart(pcb_t *proc, void *mainFunc);
 extern void procDelete(pid_t pid);
 extern int procTableContains(pid_t pid);
 extern void dispatch(ctx_t *ctx, pcb_t *prev, pcb_t *next);
 extern void schedule(ctx_t *ctx);
 int procCopy(pcb_t *parentProc, ctx_t *ctx);
-extern int procExec(void *mainFunc);
+extern int procExec(pcb_t *proc, void *mainFunc);
 
 extern int MAX_PROCS;
 extern int PROCS;
@@ -6,6 +6,7 @@
  */
 #include "processTableHistory.h"
 #include <stdlib.h>
+#include "../memory/kheap.h"
 #include "../../user/console.h"
 
 pcb_t *lastExitProc = NULL;
@@ -39,22 +40,23 @@ void procHistoryDefrag()
   return;
 }
 
-//  initialise the history table (copy of procTable that stores terminated processes)
-//    -dynamically resizing
+//  allocates the history table once, at boot, with MAX_HISTORY_PROCS entries
+void procHistoryTableInit()
+{
+  procTabHistorySize = MAX_HISTORY_PROCS;
+  procTableHistory = kcalloc(procTabHistorySize, sizeof(pcb_t));
+  return;
+}
+
+//  stores a copy of a (terminated) PCB in the history table, dropping the oldest entry if it is full
 int procHistoryInit(pcb_t *entry)
 {
-  if (HISTORY_PROCS >= procTabHistorySize && HISTORY_PROCS < MAX_HISTORY_PROCS && HISTORY_PROCS != 0)
+  if (HISTORY_PROCS >= procTabHistorySize)
   {
-    procTabHistorySize = procTabHistorySize * 2;
-    procTableHistory = realloc(procTableHistory, procTabHistorySize * sizeof(pcb_t));
-  }
-  else if (HISTORY_PROCS == 0)
-  {
-    procTabHistorySize = 1;
-    procTableHistory = malloc(sizeof(pcb_t));
+    procHistoryDelete(0);
   }
 
-  memcpy(&procTableHistory[HISTORY_PROCS], &entry, sizeof(pcb_t)); // initialise i-th PCB = main
+  memcpy(&procTableHistory[HISTORY_PROCS], entry, sizeof(pcb_t));
   HISTORY_PROCS++;
 
   return HISTORY_PROCS;
@@ -68,16 +70,10 @@ void procHistoryDelete(int entryNumber)
     memset(&procTableHistory[entryNumber], 0, sizeof(pcb_t));
     HISTORY_PROCS--;
     procHistoryDefrag();
-
-    if (HISTORY_PROCS <= (procTabHistorySize / 2))
-    {
-      procTabHistorySize = procTabHistorySize / 2;
-      procTableHistory = realloc(procTableHistory, procTabHistorySize * sizeof(pcb_t));
-    }
   }
   else
   {
-    puts("error: entry index out of range\n", 32);
+    kputs("error: entry index out of range\n", 32);
   }
   return;
 }
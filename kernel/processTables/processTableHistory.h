@@ -7,6 +7,7 @@ extern pcb_t *lastExitProc;
 extern pcb_t *procTableHistory;
 extern int procTabHistorySize;
 
+extern void procHistoryTableInit();
 extern int procHistoryInit(pcb_t *entry);
 extern void procHistoryDelete(int entryNumber);
 
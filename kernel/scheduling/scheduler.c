@@ -1,5 +1,9 @@
 #include "scheduler.h"
 #include <stdlib.h>
+#include "../memory/slab.h"
+#include "../memory/kheap.h"
+#include "../memory/userHeap.h"
+#include "../io/uart.h"
 
 //  maximum levels in mlfq - excludes Round Robin (0 implies Round Robin only)
 int MAX_QUEUE_LEVELS = 4;
@@ -37,51 +41,55 @@ int pow(int base, int exp)
   return result;
 }
 
+//  fixed capacity (MAX_PROCS) process arrays of every queue in the MLFQ
+slab_cache_t queueCache;
+
+//  queues start (and are freed) empty
+void queueCtor(void *obj)
+{
+  memset(obj, 0, MAX_PROCS * sizeof(pid_t));
+}
+
 //  create round robin queue (id = 0, t = 1)
 void invokeQueueRR()
 {
-  multiLevelQueue->queueRoundRobin = malloc(sizeof(queue_t));
+  multiLevelQueue->queueRoundRobin = kmalloc(sizeof(queue_t));
   multiLevelQueue->queueRoundRobin->id = 0;
   multiLevelQueue->queueRoundRobin->t = 1;
-  multiLevelQueue->queueRoundRobin->processes = malloc(sizeof(pid_t));
+  multiLevelQueue->queueRoundRobin->processes = slabAlloc(&queueCache);
   multiLevelQueue->queueRoundRobin->length = 0;
-  multiLevelQueue->queueRoundRobin->size = 1;
+  multiLevelQueue->queueRoundRobin->size = MAX_PROCS;
   return;
 }
 
-//  create a FCFS queue
+//  create a FCFS queue (t = 1,2,4,8...) at the next level of the mlfq
+//    -O(1) and never calls the general purpose allocator (safe from schedule())
 void invokeQueueFCFS()
 {
   //  get current number of FCFS queues in mlfq
   int levels = multiLevelQueue->levels;
-  //  create first FCFS (t = 1,2,4,8, id = 1)
-  if (levels == 0)
-  {
-    multiLevelQueue->queuesFCFS = malloc((levels + 1) * sizeof(queue_t));
-    multiLevelQueue->queuesFCFS[levels].id = levels + 1;
-    multiLevelQueue->queuesFCFS[levels].t = pow(2, levels);
-    multiLevelQueue->queuesFCFS[levels].processes = malloc(sizeof(pid_t));
-    multiLevelQueue->queuesFCFS[levels].length = 0;
-    multiLevelQueue->queuesFCFS[levels].size = 1;
-  }
-  else
+  if (levels >= MAX_QUEUE_LEVELS)
   {
-    //  add an FCFS to the mlfq with t = 1,2,4,8...
-    multiLevelQueue->queuesFCFS = realloc(multiLevelQueue->queuesFCFS, (levels + 1) * sizeof(queue_t));
-    multiLevelQueue->queuesFCFS[levels].processes = calloc(1, sizeof(pid_t));
-    multiLevelQueue->queuesFCFS[levels].id = levels + 1;
-    multiLevelQueue->queuesFCFS[levels].t = pow(2, levels);
-    multiLevelQueue->queuesFCFS[levels].length = 0;
-    multiLevelQueue->queuesFCFS[levels].size = 1;
+    return;
   }
+  multiLevelQueue->queuesFCFS[levels].id = levels + 1;
+  multiLevelQueue->queuesFCFS[levels].t = pow(2, levels);
+  multiLevelQueue->queuesFCFS[levels].processes = slabAlloc(&queueCache);
+  multiLevelQueue->queuesFCFS[levels].length = 0;
+  multiLevelQueue->queuesFCFS[levels].size = MAX_PROCS;
   multiLevelQueue->levels++;
   return;
 }
 
 //  creates the MLFQ object
+//    -every queue the MLFQ can ever need is reserved up front
 void invokeQueueMLFQ()
 {
-  multiLevelQueue = malloc(sizeof(mlfq_t));
+  slabCacheInit(&queueCache, "queue", MAX_PROCS * sizeof(pid_t), SLAB_ALIGN, &queueCtor);
+  slabCacheReserve(&queueCache, MAX_QUEUE_LEVELS + 1);
+
+  multiLevelQueue = kmalloc(sizeof(mlfq_t));
+  multiLevelQueue->queuesFCFS = kmalloc(MAX_QUEUE_LEVELS * sizeof(queue_t));
   multiLevelQueue->levels = 0;
   multiLevelQueue->processCount = 0;
   invokeQueueFCFS();
@@ -93,12 +101,14 @@ void invokeQueueMLFQ()
 //  deletes and frees the MLFQ
 void deleteMLFQ()
 {
-  free(multiLevelQueue->queueRoundRobin);
+  slabFree(&queueCache, multiLevelQueue->queueRoundRobin->processes);
+  kfree(multiLevelQueue->queueRoundRobin);
   for (int i = 0; i < multiLevelQueue->levels; i++)
   {
-    free(&multiLevelQueue->queuesFCFS[i]);
+    slabFree(&queueCache, multiLevelQueue->queuesFCFS[i].processes);
   }
-  free(multiLevelQueue);
+  kfree(multiLevelQueue->queuesFCFS);
+  kfree(multiLevelQueue);
   return;
 }
 
@@ -194,49 +204,21 @@ void queueDefrag(int level)
 }
 
 //  adds a PID to a given level in the MLFQ (level 0 = round robin)
+//    -queues hold up to MAX_PROCS entries so they never grow
 void addToQueue(pid_t pid, int level)
 {
-  if (level == 0)
-  {
-    //  if queue has room
-    if (multiLevelQueue->queueRoundRobin->length < multiLevelQueue->queueRoundRobin->size)
-    {
-      //  add pid to MLFQ
-      multiLevelQueue->queueRoundRobin->processes[multiLevelQueue->queueRoundRobin->length] = pid;
-      multiLevelQueue->queueRoundRobin->length++;
-    }
-    else
-    {
-      //  double size of queue
-      multiLevelQueue->queueRoundRobin->size = multiLevelQueue->queueRoundRobin->size * 2;
-      multiLevelQueue->queueRoundRobin->processes = realloc(multiLevelQueue->queueRoundRobin->processes, multiLevelQueue->queueRoundRobin->size * sizeof(pid_t));
-      multiLevelQueue->queueRoundRobin->processes[multiLevelQueue->queueRoundRobin->length] = pid;
-      multiLevelQueue->queueRoundRobin->length++;
-    }
-    //  make sure the processes are at the start of the array
-    queueDefrag(0);
-  }
-  else
+  queue_t *queue = (level == 0) ? multiLevelQueue->queueRoundRobin : &multiLevelQueue->queuesFCFS[level - 1];
+
+  //  if queue has room
+  if (queue->length < queue->size)
   {
-    //  if the queue has room
-    if (multiLevelQueue->queuesFCFS[level - 1].length < multiLevelQueue->queuesFCFS[level - 1].size)
-    {
-      //  add pid to MLFQ
-      multiLevelQueue->queuesFCFS[level - 1].processes[multiLevelQueue->queuesFCFS[level - 1].length] = pid;
-      multiLevelQueue->queuesFCFS[level - 1].length++;
-    }
-    else
-    {
-      //  double size of queue
-      multiLevelQueue->queuesFCFS[level - 1].size = multiLevelQueue->queuesFCFS[level - 1].size * 2;
-      multiLevelQueue->queuesFCFS[level - 1].processes = realloc(multiLevelQueue->queuesFCFS[level - 1].processes, multiLevelQueue->queuesFCFS[level - 1].size * sizeof(pid_t));
-      multiLevelQueue->queuesFCFS[level - 1].processes[multiLevelQueue->queuesFCFS[level - 1].length] = pid;
-      multiLevelQueue->queuesFCFS[level - 1].length++;
-    }
-    //  make sure the processes are at the start of the array
-    queueDefrag(level);
+    //  add pid to MLFQ
+    queue->processes[queue->length] = pid;
+    queue->length++;
+    multiLevelQueue->processCount++;
   }
-  multiLevelQueue->processCount++;
+  //  make sure the processes are at the start of the array
+  queueDefrag(level);
   return;
 }
 
@@ -282,35 +264,14 @@ void removeFromMLFQ(pid_t pid)
     //  defrag the queue
     queueDefrag(position.level);
 
-    if (position.level == 0)
+    //  if the queue can be deleted, do so
+    //  if the queue being deleted is the lowest level queue or lower
+    if (position.level > 0 && position.level >= multiLevelQueue->levels && multiLevelQueue->queuesFCFS[position.level - 1].length <= 0 && multiLevelQueue->levels > 1)
     {
-      //  if the queue can be resized, do so
-      if (multiLevelQueue->queueRoundRobin->length <= (multiLevelQueue->queueRoundRobin->size / 2) && multiLevelQueue->queueRoundRobin->size > 1)
-      {
-        //  half size of queue
-        multiLevelQueue->queueRoundRobin->size = multiLevelQueue->queueRoundRobin->size / 2;
-        multiLevelQueue->queueRoundRobin->processes = realloc(multiLevelQueue->queueRoundRobin->processes, multiLevelQueue->queueRoundRobin->size * sizeof(pid_t));
-      }
-    }
-    else
-    {
-      //  if the queue can be resized, do so
-      if (multiLevelQueue->queuesFCFS[position.level - 1].length <= (multiLevelQueue->queuesFCFS[position.level - 1].size / 2) && multiLevelQueue->queuesFCFS[position.level - 1].size > 1)
-      {
-        //  half size of queue
-        multiLevelQueue->queuesFCFS[position.level - 1].size = multiLevelQueue->queuesFCFS[position.level - 1].size / 2;
-        multiLevelQueue->queuesFCFS[position.level - 1].processes = realloc(multiLevelQueue->queuesFCFS[position.level - 1].processes, multiLevelQueue->queuesFCFS[position.level - 1].size * sizeof(pid_t));
-      }
-
-      //  if the queue can be deleted, do so
-      //  if the queue being deleted is the lowest level queue or lower
-      if (position.level >= multiLevelQueue->levels && multiLevelQueue->queuesFCFS[position.level - 1].length <= 0 && multiLevelQueue->levels > 1)
-      {
-        int levels = multiLevelQueue->levels;
-        memset(&multiLevelQueue->queuesFCFS[levels - 1], 0, sizeof(queue_t));
-        multiLevelQueue->queuesFCFS = realloc(multiLevelQueue->queuesFCFS, (levels - 1) * sizeof(queue_t));
-        multiLevelQueue->levels--;
-      }
+      int levels = multiLevelQueue->levels;
+      slabFree(&queueCache, multiLevelQueue->queuesFCFS[levels - 1].processes);
+      memset(&multiLevelQueue->queuesFCFS[levels - 1], 0, sizeof(queue_t));
+      multiLevelQueue->levels--;
     }
     multiLevelQueue->processCount--;
   }
@@ -333,13 +294,17 @@ void dispatch(ctx_t *ctx, pcb_t *prev, pcb_t *next)
     next_pid = '0' + next->pid;
   }
 
-  PL011_putc(UART0, '[', true);
-  PL011_putc(UART0, prev_pid, true);
-  PL011_putc(UART0, '-', true);
-  PL011_putc(UART0, '>', true);
-  PL011_putc(UART0, next_pid, true);
-  PL011_putc(UART0, ']', true);
-  prev->status = STATUS_READY;
+  uartPutc(&uartTable[0], '[');
+  uartPutc(&uartTable[0], prev_pid);
+  uartPutc(&uartTable[0], '-');
+  uartPutc(&uartTable[0], '>');
+  uartPutc(&uartTable[0], next_pid);
+  uartPutc(&uartTable[0], ']');
+  //  a waiting or terminated P_{prev} keeps its status
+  if (NULL != prev && prev->status == STATUS_EXECUTING)
+  {
+    prev->status = STATUS_READY;
+  }
 
   //  if the process is not in the MLFQ, initialise it in the MLFQ
   if (inMLFQ(next->pid).level < 0)
@@ -347,12 +312,116 @@ void dispatch(ctx_t *ctx, pcb_t *prev, pcb_t *next)
     addToMLFQ(next->pid);
   }
 
+  //  publish the heap of P_{next} to user space
+  userHeapPublish(next);
+
   currentProc = next; // update executing process to P_{next}
   currentProc->status = STATUS_EXECUTING;
 
   return;
 }
 
+//  make a blocked process runnable: back into the top-level queue, as if newly created
+void scheduleWake(pcb_t *proc)
+{
+  proc->status = STATUS_READY;
+  proc->priority = 1;
+  if (inMLFQ(proc->pid).level < 0)
+  {
+    addToQueue(proc->pid, 1);
+  }
+  return;
+}
+
+/*  wake-and-switch: the first process woken from a wait queue during a system call (waitResume),
+    dispatched at the end of the call by scheduleHandoff  */
+pcb_t *scheduleWoken = NULL;
+
+/*  switch straight from caller (the process that made the system call) to the process it woke,
+    which runs for the rest of the timer period, if caller asked to (sched_handoff) or the woken
+    process is the more urgent; does nothing if the call has already switched away from caller  */
+void scheduleHandoff(ctx_t *ctx, pcb_t *caller)
+{
+    pcb_t *next = scheduleWoken;
+
+    scheduleWoken = NULL;
+    if (next == NULL || next == caller || currentProc != caller || caller->status != STATUS_EXECUTING || next->status != STATUS_READY)
+    {
+        return;
+    }
+    if (caller->handoff || next->priority < caller->priority)
+    {
+        dispatch(ctx, caller, next);
+    }
+    return;
+}
+
+//  the level of the MLFQ a process of priority p is kept in (0 = round robin), as schedule() places it
+int scheduleLevel(int p)
+{
+  if (p > pow(2, MAX_QUEUE_LEVELS - 1))
+  {
+    return 0;
+  }
+  int l = 0;
+  while (pow(2, l + 1) <= p)
+  {
+    l++;
+  }
+  return l + 1;
+}
+
+//  move a runnable process to the level matching its (just changed) priority
+void scheduleRequeue(pcb_t *proc)
+{
+  if (proc->status == STATUS_WAITING || proc->priority == 0)
+  {
+    return;
+  }
+  int level = scheduleLevel(proc->priority);
+  removeFromMLFQ(proc->pid);
+  while (level > multiLevelQueue->levels && multiLevelQueue->levels < MAX_QUEUE_LEVELS)
+  {
+    invokeQueueFCFS();
+  }
+  addToQueue(proc->pid, level);
+  return;
+}
+
+//  returns true if the process with the given PID can be dispatched
+bool scheduleRunnable(pid_t pid)
+{
+  int slot = procTableContains(pid);
+  return pid != 0 && slot >= 0 && &procTable[slot] != currentProc && procTable[slot].status == STATUS_READY && procTable[slot].priority != 0;
+}
+
+/*  switch away from P_{current} once it has blocked (set STATUS_WAITING and left the MLFQ):
+    dispatches the first runnable process, top-level queue first
+      -returns false (dispatching nothing) if no other process can run  */
+bool scheduleBlock(ctx_t *ctx)
+{
+  for (int x = 0; x < multiLevelQueue->levels; x++)
+  {
+    for (int y = 0; y < multiLevelQueue->queuesFCFS[x].length; y++)
+    {
+      if (scheduleRunnable(multiLevelQueue->queuesFCFS[x].processes[y]))
+      {
+        dispatch(ctx, currentProc, &procTable[procTableContains(multiLevelQueue->queuesFCFS[x].processes[y])]);
+        return true;
+      }
+    }
+  }
+  for (int z = 0; z < multiLevelQueue->queueRoundRobin->length; z++)
+  {
+    if (scheduleRunnable(multiLevelQueue->queueRoundRobin->processes[z]))
+    {
+      dispatch(ctx, currentProc, &procTable[procTableContains(multiLevelQueue->queueRoundRobin->processes[z])]);
+      return true;
+    }
+  }
+  return false;
+}
+
 /*  MLFQ priority-based scheduler with [MAX_QUEUE_LEVELS] FCFS queues and a bottom-level (id/level = 0) Round Robin queue.
       -dynamically resizing queues of size 2^n on add/remove
       -dynamically resizing queue levels (unnessecary queues are removed, more are added if needed up to MAX_QUEUE_LEVELS)
@@ -367,21 +436,33 @@ void schedule(ctx_t *ctx)
     //  if there is multiprocessing
     if (PROCS > 1)
     {
-      //  loop over all process in procTable
-      for (int i = 0; i < PROCS; i++)
+      //  loop over all process in procTable (skipping free slots)
+      for (int i = 0; i < procTabSize; i++)
       {
-        //  if STATUS_INVALID, try restart the process
+        if (procTable[i].pid == 0)
+        {
+          continue;
+        }
+        //  if STATUS_INVALID, try restart the process (in place: nothing is allocated in IRQ mode)
         switch (procTable[i].status)
         {
         case (STATUS_INVALID):
         {
-          uint32_t iprocTos = procTable[i].tos;
-          procDelete(procTable[i].pid);
-          pid_t iprocPid = procInit(&iprocTos);
+          procRestart(&procTable[i], (void *)procTable[i].entry);
+          break;
+        }
+        //  blocked or paused: kept off the MLFQ until woken (scheduleWake) or unpaused
+        case (STATUS_WAITING):
+        {
           break;
         }
         default:
         {
+          //  a process holding a mutex at an inherited priority stays at that level until it unlocks
+          if (procTable[i].inherited != 0)
+          {
+            break;
+          }
           //  if the processes are all not in the round robin, increment priority
           if (multiLevelQueue->queueRoundRobin->length != PROCS)
           {
@@ -429,11 +510,11 @@ void schedule(ctx_t *ctx)
         //  loop over all FCFS queues
         for (int x = 0; x < multiLevelQueue->levels; x++)
         {
-          PL011_putc(UART0, 'x', true);
+          uartPutc(&uartTable[0], 'x');
           //  loop over all items in the queue
           for (int y = 0; y < multiLevelQueue->queuesFCFS[x].length; y++)
           {
-            PL011_putc(UART0, 'y', true);
+            uartPutc(&uartTable[0], 'y');
             //  if the process in this queue  and if process priority != 0 and has status != STATUS_WAITING and is not the current process
             if (multiLevelQueue->queuesFCFS[x].processes[y] != currentProc->pid &&
                 multiLevelQueue->queuesFCFS[x].processes[y] != 0 && procTable[procTableContains(multiLevelQueue->queuesFCFS[x].processes[y])].status != STATUS_WAITING && procTable[procTableContains(multiLevelQueue->queuesFCFS[x].processes[y])].priority != 0)
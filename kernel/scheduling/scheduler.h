@@ -40,5 +40,11 @@ extern void deleteMLFQ();
 extern void enableMLFQ();
 extern void disableMLFQ();
 extern void addToMLFQ(pid_t pid);
+extern pcb_t *scheduleWoken;
+
+extern void scheduleWake(pcb_t *proc);
+extern void scheduleHandoff(ctx_t *ctx, pcb_t *caller);
+extern void scheduleRequeue(pcb_t *proc);
+extern bool scheduleBlock(ctx_t *ctx);
 
 #endif
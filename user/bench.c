@@ -0,0 +1,67 @@
+#include "bench.h"
+#include <string.h>
+
+uint32_t benchTime()
+{
+  return SYSCONF->COUNTER_24MHZ;
+}
+
+//  write a string then an unsigned integer to stdout
+void benchPut(char *x, uint32_t n)
+{
+  char string[12];
+  char *p = string + sizeof(string) - 1;
+
+  *p = '\x00';
+  do
+  {
+    *--p = '0' + (n % 10);
+    n /= 10;
+  } while (n);
+
+  write(STDOUT_FILENO, x, strlen(x));
+  write(STDOUT_FILENO, p, strlen(p));
+}
+
+void benchReport(char *label, uint32_t ops, uint32_t ticks)
+{
+  if (ticks == 0)
+  {
+    ticks = 1;
+  }
+  write(STDOUT_FILENO, "\n", 1);
+  write(STDOUT_FILENO, label, strlen(label));
+  benchPut(": ", ops);
+  benchPut(" ops in ", (uint32_t)(((uint64_t)ticks * 1000000) / BENCH_HZ));
+  benchPut(" us = ", (uint32_t)(((uint64_t)ops * BENCH_HZ) / ticks));
+  write(STDOUT_FILENO, " ops/s\n", 7);
+}
+
+//  KB/s rather than MB/s, so slow paths don't round to 0
+void benchThroughput(char *label, uint32_t bytes, uint32_t ticks)
+{
+  if (ticks == 0)
+  {
+    ticks = 1;
+  }
+  write(STDOUT_FILENO, "\n", 1);
+  write(STDOUT_FILENO, label, strlen(label));
+  benchPut(": ", bytes);
+  benchPut(" bytes in ", (uint32_t)(((uint64_t)ticks * 1000000) / BENCH_HZ));
+  benchPut(" us = ", (uint32_t)(((uint64_t)bytes * BENCH_HZ) / ((uint64_t)ticks * 1024)));
+  write(STDOUT_FILENO, " KB/s\n", 6);
+}
+
+void benchLatency(char *label, uint32_t n, uint32_t totalTicks, uint32_t maxTicks)
+{
+  if (n == 0)
+  {
+    n = 1;
+  }
+  write(STDOUT_FILENO, "\n", 1);
+  write(STDOUT_FILENO, label, strlen(label));
+  benchPut(": ", n);
+  benchPut(" samples, avg ", (uint32_t)(((uint64_t)totalTicks * 1000000) / ((uint64_t)n * BENCH_HZ)));
+  benchPut(" us, max ", (uint32_t)(((uint64_t)maxTicks * 1000000) / BENCH_HZ));
+  write(STDOUT_FILENO, " us\n", 4);
+}
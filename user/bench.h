@@ -0,0 +1,24 @@
+#ifndef __BENCH_H
+#define __BENCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "SYS.h"
+
+#include "libc.h"
+
+// frequency of the SYSCONF counter used for timing
+#define BENCH_HZ (24000000)
+
+// read the 24 MHz counter
+extern uint32_t benchTime();
+// write "<label>: <ops> ops in <us> us = <ops/s> ops/s" to stdout
+extern void benchReport(char *label, uint32_t ops, uint32_t ticks);
+// write "<label>: <bytes> bytes in <us> us = <KB/s> KB/s" to stdout
+extern void benchThroughput(char *label, uint32_t bytes, uint32_t ticks);
+// write "<label>: <n> samples, avg <us> us, max <us> us" to stdout
+extern void benchLatency(char *label, uint32_t n, uint32_t totalTicks, uint32_t maxTicks);
+
+#endif
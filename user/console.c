@@ -9,29 +9,38 @@
 
 /* The following functions are special-case versions of a) writing, and 
  * b) reading a string from the UART (the latter case returning once a 
- * carriage return character has been read, or a limit is reached).
+ * carriage return character has been read, or a limit is reached). Both
+ * go through the console's descriptor, so output is ordered with any
+ * other write to it; the kernel buffers console input a line at a time,
+ * so gets sleeps until a whole line has been typed rather than polling
+ * the UART.
  */
 
 void puts(char *x, int n)
 {
-  for (int i = 0; i < n; i++)
-  {
-    PL011_putc(UART1, x[i], true);
-  }
+  write(CONSOLE_FILENO, x, n);
 }
 
 void gets(char *x, int n)
 {
-  for (int i = 0; i < n; i++)
+  int len = 0;
+
+  while (len < n - 1)
   {
-    x[i] = PL011_getc(UART1, true);
+    int r = read(CONSOLE_FILENO, x + len, n - 1 - len);
+    if (r <= 0)
+    {
+      break;
+    }
+    len += r;
 
-    if (x[i] == '\x0A')
+    if (x[len - 1] == '\x0A')
     {
-      x[i] = '\x00';
+      len--;
       break;
     }
   }
+  x[len] = '\x00';
 }
 
 /* Since we lack a *real* loader (as a result of also lacking a storage
@@ -44,6 +53,13 @@ extern void main_P3();
 extern void main_P4();
 extern void main_P5();
 extern void main_diningPhil();
+extern void main_mallocBench();
+extern void main_pinvBench();
+extern void main_pipeBench();
+extern void main_ipcBench();
+extern void main_ringBench();
+extern void main_ioBench();
+extern void main_diskBench();
 
 void *load(char *x)
 {
@@ -63,6 +79,34 @@ void *load(char *x)
   {
     return &main_diningPhil;
   }
+  else if (0 == strcmp(x, "mallocBench"))
+  {
+    return &main_mallocBench;
+  }
+  else if (0 == strcmp(x, "pinvBench"))
+  {
+    return &main_pinvBench;
+  }
+  else if (0 == strcmp(x, "pipeBench"))
+  {
+    return &main_pipeBench;
+  }
+  else if (0 == strcmp(x, "ipcBench"))
+  {
+    return &main_ipcBench;
+  }
+  else if (0 == strcmp(x, "ringBench"))
+  {
+    return &main_ringBench;
+  }
+  else if (0 == strcmp(x, "ioBench"))
+  {
+    return &main_ioBench;
+  }
+  else if (0 == strcmp(x, "diskBench"))
+  {
+    return &main_diskBench;
+  }
 
   return NULL;
 }
@@ -123,6 +167,9 @@ void main_console()
         execute/exec/e [P3/P4/P5]
           -executes a user process
 
+        execute-quiet/eq [P3/P4/P5]
+          -executes a user process with its standard output discarded
+
         fork/f [PID]
           -forks a process
 
@@ -143,6 +190,18 @@ void main_console()
 
         history/h
           -shows all killed process table entries (entries in the history table)
+
+        slabs
+          -shows the usage of the kernel slab caches
+
+        pages
+          -shows the free block count of every order of the page allocator
+
+        memstat
+          -shows the kernel heap totals, free chunk histogram and allocation call-sites
+
+        lockstat [N]
+          -shows the N (default 8) semaphores with the most time spent waiting on them
         
         pause/stop/p [PID]
           -pauses a process in the process table (sets priority = 0, removes from scheduler)
@@ -169,6 +228,28 @@ void main_console()
       }
     }
 
+    //  EXECUTE-QUIET/EQ
+    else if (0 == strcmp(cmd_argv[0], "execute-quiet") || 0 == strcmp(cmd_argv[0], "eq"))
+    {
+      void *addr = load(cmd_argv[1]);
+
+      if (addr != NULL)
+      {
+        if (0 == fork())
+        {
+          //  point the child's standard output at the null sink, then run the program
+          int sink = fd_open(FILE_NULL, 0);
+          dup2(sink, STDOUT_FILENO);
+          fd_close(sink);
+          exec(addr);
+        }
+      }
+      else
+      {
+        puts("unknown program\n", 16);
+      }
+    }
+
     //  TERMINATE/KILL/K
     else if (0 == strcmp(cmd_argv[0], "terminate") || 0 == strcmp(cmd_argv[0], "kill") || 0 == strcmp(cmd_argv[0], "k"))
     {
@@ -205,6 +286,30 @@ void main_console()
       history();
     }
 
+    //  SLABS
+    else if (0 == strcmp(cmd_argv[0], "slabs"))
+    {
+      slabs();
+    }
+
+    //  PAGES
+    else if (0 == strcmp(cmd_argv[0], "pages"))
+    {
+      pages();
+    }
+
+    //  MEMSTAT
+    else if (0 == strcmp(cmd_argv[0], "memstat"))
+    {
+      memstat();
+    }
+
+    //  LOCKSTAT
+    else if (0 == strcmp(cmd_argv[0], "lockstat"))
+    {
+      lockstat((cmd_argc > 1) ? atoiLocal(cmd_argv[1]) : 8);
+    }
+
     //  PRIORITY/PRIO/P
     else if (0 == strcmp(cmd_argv[0], "priority") || 0 == strcmp(cmd_argv[0], "prio") || 0 == strcmp(cmd_argv[0], "p"))
     {
@@ -1,86 +1,126 @@
 #include "diningPhil.h"
+#include <string.h>
+
+//  table sizes measured, up to PHIL_MAX philosophers
+#define PHIL_MAX (128)
+//  processes sharing the philosophers of a table (procTable holds MAX_PROCS)
+#define PHIL_PROCS (16)
+//  meals eaten (by the whole table) per measurement
+#define PHIL_MEALS (4096)
 
 int philosophers = 16;
+//  true: take both forks with one semop, false: one sem_wait per fork
+bool philSemop = false;
+
+sem_t sems[PHIL_MAX];
+//  meals eaten by the whole table (no MMU, so the forked philosophers all share these globals)
+int meals;
+//  posted by the philosopher that eats the last meal of a measurement
+sem_t done;
+
+/*  philosopher philId (1...philosophers) shares fork philId - 1 on the left and fork philId % philosophers
+    on the right; with sem_wait, odd philosophers pick up left first and even right first, so no cycle
+    of waits forms, while semop takes both at once or neither  */
+void philEat(int philId)
+{
+    sem_t *leftSem = &sems[philId - 1];
+    sem_t *rightSem = &sems[philId % philosophers];
 
-int *addrSpace[8];
-sem_t sems[16];
+    if (philSemop)
+    {
+        sembuf_t ops[2] = {{leftSem, -1}, {rightSem, -1}};
+        semop(ops, 2);
+    }
+    else if (philId % 2 == 1)
+    {
+        sem_wait(leftSem);
+        sem_wait(rightSem);
+    }
+    else
+    {
+        sem_wait(rightSem);
+        sem_wait(leftSem);
+    }
+    if (atomicAdd(&meals, 1) == PHIL_MEALS - 1)
+    {
+        sem_post(&done);
+    }
+    //  a free fork is put down without a system call; one wanted by a blocked philosopher enters the kernel
+    sem_post(leftSem);
+    sem_post(rightSem);
+}
 
-void philOp(int philId)
+//  process proc eats for philosophers proc, proc + PHIL_PROCS, ... in turn
+void philOp(int proc)
 {
-    sem_t leftSem;
-    sem_t rightSem;
-    if (philId != 0)
+    while (1)
     {
-        if (philId < philosophers)
+        for (int philId = proc; philId <= philosophers; philId += PHIL_PROCS)
         {
-            leftSem = sems[philId - 1];
-            rightSem = sems[philId];
+            philEat(philId);
         }
-        else
+    }
+}
+
+//  time PHIL_MEALS meals at a table of n, then stop the philosophers and put every fork back
+void philTable(int n, bool useSemop)
+{
+    char label[64];
+    pid_t pids[PHIL_PROCS];
+    int procs = (n < PHIL_PROCS) ? n : PHIL_PROCS;
+
+    philosophers = n;
+    philSemop = useSemop;
+    meals = 0;
+    uint32_t start = benchTime();
+
+    for (int p = 0; p < procs; p++)
+    {
+        pids[p] = fork();
+        if (pids[p] == 0)
         {
-            leftSem = sems[philId - 1];
-            rightSem = sems[0];
+            philOp(p + 1);
         }
     }
+    sem_wait(&done);
+    uint32_t ticks = benchTime() - start;
 
-    while (1)
+    for (int p = 0; p < procs; p++)
+    {
+        kill(pids[p], EXIT_SUCCESS);
+    }
+    //  killed waiters have been taken off the semaphores; return the forks held by killed eaters
+    for (int i = 0; i < n; i++)
     {
-        if (philId != 0)
+        while (sems[i].value < 1)
         {
-            //  if odd ID
-            if (philId % 2 == 1)
-            {
-                /*
-                int value;
-                value = *(int *)addrSpace[philId / 2];
-                value++;
-                shm_write(addrSpace[philId / 2], value, sizeof(int));*/
-                sem_post(rightSem);
-                sem_wait(leftSem);
-            }
-            else // if even ID
-            {
-                sem_wait(leftSem);
-                /*
-                int value;
-                value = *(int *)addrSpace[(philId / 2) - 1];
-                value++;
-                shm_write(addrSpace[(philId / 2) - 1], value, sizeof(int));
-                */
-                sem_post(rightSem);
-            }
+            sem_post(&sems[i]);
         }
     }
-    return;
+
+    strcpy(label, useSemop ? "diningPhil semop, " : "diningPhil sem_wait, ");
+    itoaLocal(label + strlen(label), n);
+    strcat(label, " philosophers (meals)");
+    benchReport(label, PHIL_MEALS, ticks);
 }
 
+/*  meals per second for 16 to PHIL_MAX philosophers, taking forks one sem_wait at a time and
+    both with one semop (more philosophers than PHIL_PROCS share processes)  */
 void main_diningPhil()
 {
-    int philId = 0; //  0 = PARENT
-    //  if this is the parent process, allocate a shared integer array of length 8
-    //  if this is the parent process, allocate an array of semaphores
-    for (int i = 0; i < philosophers / 2; i++)
+    //  one semaphore (fork) per philosopher, each initially free
+    for (int i = 0; i < PHIL_MAX; i++)
     {
-        /*
-        void *addrSpaceItem = shm_init(sizeof(int));
-        addrSpace[i] = addrSpaceItem;
-        */
-        sems[i] = sem_init();
-        sems[i + (philosophers / 2)] = sem_init();
+        sem_init(&sems[i]);
+        sem_post(&sems[i]);
     }
+    sem_init(&done);
 
-    //  fork process 16 times and set philId = 1...16 and give each philosopher a left and right neighbour (semaphore)
-    for (int j = 1; j <= philosophers; j++)
+    for (int n = 16; n <= PHIL_MAX; n *= 2)
     {
-        philId = j;
-
-        if (fork() == 0)
-        {
-            break;
-        }
+        philTable(n, false);
+        philTable(n, true);
     }
-    philOp(philId);
-    //  do philOp indefinitely (increment memSpace[i] or wait)
 
     exit(EXIT_SUCCESS);
 }
@@ -4,5 +4,6 @@
 #include "libc.h"
 #include <stdlib.h>
 #include "console.h"
+#include "bench.h"
 
-#endif
\ No newline at end of file
+#endif
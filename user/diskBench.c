@@ -0,0 +1,74 @@
+#include "diskBench.h"
+#include <string.h>
+
+//  bytes written then read back per protocol, in DISK_CHUNK-byte system calls, from block 0
+#define DISK_BYTES (4096)
+#define DISK_CHUNK (256)
+
+uint8_t diskBuf[DISK_BYTES];
+
+//  stream DISK_BYTES to the disk then back in chunk-byte calls, reporting both rates and checking what came back
+void diskStream(int fd, int chunk, char *writeLabel, char *readLabel)
+{
+  uint8_t *x = diskBuf;
+  uint32_t t;
+  bool same = true;
+
+  fd_seek(fd, 0);
+  t = benchTime();
+  for (uint32_t done = 0; done < DISK_BYTES; done += chunk)
+  {
+    for (int i = 0; i < chunk; i++)
+    {
+      x[i] = (uint8_t)(done + i);
+    }
+    write(fd, x, chunk);
+  }
+  benchThroughput(writeLabel, DISK_BYTES, benchTime() - t);
+
+  fd_seek(fd, 0);
+  t = benchTime();
+  for (uint32_t done = 0; done < DISK_BYTES; done += chunk)
+  {
+    read(fd, x, chunk);
+    for (int i = 0; i < chunk; i++)
+    {
+      same = same && x[i] == (uint8_t)(done + i);
+    }
+  }
+  benchThroughput(readLabel, DISK_BYTES, benchTime() - t);
+
+  if (!same)
+  {
+    write(STDOUT_FILENO, "\ndisk read back different data\n", 31);
+  }
+}
+
+/*  disk throughput with binary frames against the original hex lines, in DISK_CHUNK-byte calls
+    and in one call (moved as multi-block requests) (the disk must be running: make launch-disk);
+    overwrites the first DISK_BYTES of the disk  */
+void main_diskBench()
+{
+  int fd = fd_open(FILE_DISK, 0);
+  if (fd < 0)
+  {
+    exit(EXIT_FAILURE);
+  }
+
+  if (disk_set_mode(DISK_BIN) == DISK_BIN)
+  {
+    diskStream(fd, DISK_CHUNK, "disk write, binary frames", "disk read, binary frames");
+    diskStream(fd, DISK_BYTES, "disk write, binary frames, one call", "disk read, binary frames, one call");
+  }
+  else
+  {
+    write(STDOUT_FILENO, "\ndisk only speaks hex\n", 22);
+  }
+  disk_set_mode(DISK_HEX);
+  diskStream(fd, DISK_CHUNK, "disk write, hex lines", "disk read, hex lines");
+  diskStream(fd, DISK_BYTES, "disk write, hex lines, one call", "disk read, hex lines, one call");
+  disk_set_mode(DISK_BIN);
+
+  fd_close(fd);
+  exit(EXIT_SUCCESS);
+}
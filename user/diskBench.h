@@ -0,0 +1,11 @@
+#ifndef __DISKBENCH_H
+#define __DISKBENCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libc.h"
+#include "bench.h"
+
+#endif
@@ -0,0 +1,117 @@
+#include "ioBench.h"
+#include <string.h>
+
+//  writes per measurement, of IO_LEN bytes each
+#define IO_OPS (4096)
+#define IO_LEN (16)
+//  ring slots, and writes submitted per io_enter
+#define IO_ENTRIES (64)
+#define IO_BATCH (32)
+
+//  shared by the forked processes (no MMU)
+pipe_t ioPipe;
+
+io_sqe_t ioSq[IO_ENTRIES];
+io_cqe_t ioCq[IO_ENTRIES];
+io_ring_t ioRing;
+
+//  reads everything the parent writes to ioPipe, then exits
+void ioConsumer()
+{
+  uint8_t x[256];
+  uint32_t got = 0;
+
+  while (got < IO_OPS * IO_LEN)
+  {
+    int r = pipe_read(ioPipe, x, sizeof(x), 0);
+    if (r < 0)
+    {
+      break;
+    }
+    got += r;
+  }
+  exit(EXIT_SUCCESS);
+}
+
+//  IO_OPS writes to fd, one write system call each
+uint32_t ioSync(int fd, uint8_t *x)
+{
+  uint32_t t = benchTime();
+  for (int i = 0; i < IO_OPS; i++)
+  {
+    write(fd, x, IO_LEN);
+  }
+  return benchTime() - t;
+}
+
+//  IO_OPS writes to fd through the ring, IO_BATCH submitted (and reaped) per io_enter
+uint32_t ioAsync(int fd, uint8_t *x)
+{
+  io_cqe_t cqe;
+  uint32_t t = benchTime();
+
+  for (int sent = 0; sent < IO_OPS;)
+  {
+    int batch = 0;
+    while (batch < IO_BATCH && sent < IO_OPS && io_submit(&ioRing, IORING_OP_WRITE, fd, x, IO_LEN, sent))
+    {
+      batch++;
+      sent++;
+    }
+    io_enter(batch);
+    while (io_reap(&ioRing, &cqe))
+    {
+    }
+  }
+  return benchTime() - t;
+}
+
+//  time IO_OPS writes to fd synchronously and through the ring (a forked child drains a pipe)
+void ioCompare(char *syncLabel, char *asyncLabel, int fd, uint8_t *x, bool drain)
+{
+  pid_t pid = drain ? fork() : -1;
+  if (pid == 0)
+  {
+    ioConsumer();
+  }
+  benchReport(syncLabel, IO_OPS, ioSync(fd, x));
+
+  pid = drain ? fork() : -1;
+  if (pid == 0)
+  {
+    ioConsumer();
+  }
+  benchReport(asyncLabel, IO_OPS, ioAsync(fd, x));
+}
+
+/*  write system calls per second against writes through an asynchronous ring, to the null sink
+    (the cost of entering the kernel) and to a pipe drained by a forked child  */
+void main_ioBench()
+{
+  uint8_t x[IO_LEN];
+  memset(x, 0xA5, sizeof(x));
+
+  ioRing.entries = IO_ENTRIES;
+  ioRing.sq = ioSq;
+  ioRing.cq = ioCq;
+  if (io_setup(&ioRing) < 0)
+  {
+    exit(EXIT_FAILURE);
+  }
+
+  int sink = fd_open(FILE_NULL, 0);
+  ioCompare("write, null sink (16-byte writes)", "io ring, null sink (16-byte writes)", sink, x, false);
+  fd_close(sink);
+
+  ioPipe = pipe_init(0);
+  int fd = fd_open(FILE_PIPE, ioPipe);
+  if (ioPipe < 0 || fd < 0)
+  {
+    exit(EXIT_FAILURE);
+  }
+  ioCompare("write, pipe (16-byte writes)", "io ring, pipe (16-byte writes)", fd, x, true);
+  fd_close(fd);
+  pipe_destroy(ioPipe);
+
+  exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,11 @@
+#ifndef __IOBENCH_H
+#define __IOBENCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libc.h"
+#include "bench.h"
+
+#endif
@@ -0,0 +1,110 @@
+#include "ipcBench.h"
+
+//  round trips timed
+#define IPC_ROUNDS (1 << 12)
+//  semaphore ping-pong round trips timed
+#define PING_ROUNDS (1 << 8)
+
+//  shared by the forked processes (no MMU)
+sem_t ping;
+sem_t pong;
+
+//  an echo server: each reply is the request with its first word incremented
+void ipcEchoServer()
+{
+  ipc_msg_t msg;
+  pid_t client = IPC_NONE;
+
+  while (1)
+  {
+    //  any PID is a caller to answer, the console's (-1) included
+    client = ipc_reply_wait(client, &msg);
+    msg.w[0]++;
+  }
+}
+
+//  answer every ping with a pong
+void pongServer(bool handoff)
+{
+  sched_handoff(handoff);
+  while (1)
+  {
+    sem_wait(&ping);
+    sem_post(&pong);
+  }
+}
+
+//  ping-pong round trip latency over two semaphores, with and without switching on every wake
+void pingPong(char *label, bool handoff)
+{
+  uint32_t total = 0;
+  uint32_t max = 0;
+
+  pid_t server = fork();
+  if (server == 0)
+  {
+    pongServer(handoff);
+  }
+  sched_handoff(handoff);
+  for (uint32_t i = 0; i < PING_ROUNDS; i++)
+  {
+    uint32_t t = benchTime();
+    sem_post(&ping);
+    sem_wait(&pong);
+    t = benchTime() - t;
+
+    total += t;
+    if (t > max)
+    {
+      max = t;
+    }
+  }
+  sched_handoff(false);
+  //  the server is blocked on ping again, so both semaphores are left at 0
+  kill(server, EXIT_SUCCESS);
+  benchLatency(label, PING_ROUNDS, total, max);
+}
+
+/*  call/reply round trip latency against a forked echo server; with the server
+    always waiting in ipc_reply_wait, every call and reply is a direct switch  */
+void main_ipcBench()
+{
+  ipc_msg_t msg;
+  uint32_t total = 0;
+  uint32_t max = 0;
+
+  pid_t server = fork();
+  if (server == 0)
+  {
+    ipcEchoServer();
+  }
+
+  for (uint32_t i = 0; i < IPC_ROUNDS; i++)
+  {
+    msg.w[0] = i;
+    uint32_t t = benchTime();
+    int r = ipc_call(server, &msg);
+    t = benchTime() - t;
+
+    if (r < 0 || msg.w[0] != i + 1)
+    {
+      write(STDOUT_FILENO, "\nipc_call failed\n", 17);
+      break;
+    }
+    total += t;
+    if (t > max)
+    {
+      max = t;
+    }
+  }
+
+  kill(server, EXIT_SUCCESS);
+  benchLatency("ipc_call round trip", IPC_ROUNDS, total, max);
+  benchReport("ipc_call", IPC_ROUNDS, total);
+
+  sem_init(&ping);
+  sem_init(&pong);
+  pingPong("sem ping-pong round trip", false);
+  pingPong("sem ping-pong round trip (sched_handoff)", true);
+  exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,11 @@
+#ifndef __IPCBENCH_H
+#define __IPCBENCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libc.h"
+#include "bench.h"
+
+#endif
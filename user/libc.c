@@ -6,6 +6,7 @@
  */
 
 #include "libc.h"
+#include <string.h>
 
 int atoiLocal(char *x)
 {
@@ -85,31 +86,40 @@ void yield(pid_t pid)
 int write(int fd, const void *x, size_t n)
 {
   int r;
+  const uint8_t *end;
 
-  asm volatile("mov r0, %2 \n" // assign r0 = fd
-               "mov r1, %3 \n" // assign r1 =  x
-               "mov r2, %4 \n" // assign r2 =  n
-               "svc %1     \n" // make system call SYS_WRITE
+  asm volatile("mov r0, %3 \n" // assign r0 = fd
+               "mov r1, %4 \n" // assign r1 =  x
+               "mov r2, %5 \n" // assign r2 =  n
+               "svc %2     \n" // make system call SYS_WRITE
                "mov %0, r0 \n" // assign r  = r0
-               : "=r"(r)
+               "mov %1, r1 \n" // assign end = r1
+               : "=r"(r), "=r"(end)
                : "I"(SYS_WRITE), "r"(fd), "r"(x), "r"(n)
                : "r0", "r1", "r2");
 
-  return r;
+  //  a write that blocked finishes with the bytes moved by its last (restarted) step, from x advanced past the rest
+  return (r >= 0) ? (int)(end - (const uint8_t *)x) + r : r;
 }
 
 int read(int fd, void *x, size_t n)
+{
+  return read_timeout(fd, x, n, -1);
+}
+
+int read_timeout(int fd, void *x, size_t n, int timeout)
 {
   int r;
 
   asm volatile("mov r0, %2 \n" // assign r0 = fd
                "mov r1, %3 \n" // assign r1 =  x
                "mov r2, %4 \n" // assign r2 =  n
+               "mov r3, %5 \n" // assign r3 =  timeout
                "svc %1     \n" // make system call SYS_READ
                "mov %0, r0 \n" // assign r  = r0
                : "=r"(r)
-               : "I"(SYS_READ), "r"(fd), "r"(x), "r"(n)
-               : "r0", "r1", "r2");
+               : "I"(SYS_READ), "r"(fd), "r"(x), "r"(n), "r"(timeout)
+               : "r0", "r1", "r2", "r3");
 
   return r;
 }
@@ -227,6 +237,17 @@ void unpause(pid_t pid)
   return;
 }
 
+void sched_handoff(bool on)
+{
+  asm volatile("mov r0, %1 \n" // assign r0 = on
+               "svc %0     \n" // make system call SYS_HANDOFF
+               :
+               : "I"(SYS_HANDOFF), "r"(on)
+               : "r0");
+
+  return;
+}
+
 int forkProc(pid_t pid)
 {
   int r;
@@ -253,101 +274,1077 @@ int getaddr()
   return r;
 }
 
-//  initialise an empty (0) semaphore
-sem_t sem_init()
+void slabs()
+{
+  asm volatile("svc %0     \n" // make system call SYS_SLABS
+               :
+               : "I"(SYS_SLABS));
+
+  return;
+}
+
+void pages()
+{
+  asm volatile("svc %0     \n" // make system call SYS_PAGES
+               :
+               : "I"(SYS_PAGES));
+
+  return;
+}
+
+void memstat()
+{
+  asm volatile("svc %0     \n" // make system call SYS_MEMSTAT
+               :
+               : "I"(SYS_MEMSTAT));
+
+  return;
+}
+
+void lockstat(int n)
+{
+  asm volatile("mov r0, %1 \n" // assign r0 = n
+               "svc %0     \n" // make system call SYS_LOCKSTAT
+               :
+               : "I"(SYS_LOCKSTAT), "r"(n)
+               : "r0");
+
+  return;
+}
+
+int brk(void *addr)
+{
+  int r;
+
+  asm volatile("mov r0, %2 \n" // assign r0 = addr
+               "svc %1     \n" // make system call SYS_BRK
+               "mov %0, r0 \n" // assign r  = r0
+               : "=r"(r)
+               : "I"(SYS_BRK), "r"(addr)
+               : "r0");
+
+  return r;
+}
+
+void *sbrk(int incr)
 {
-  sem_t r;
+  void *r;
 
-  asm volatile("svc %1     \n" // make system call SYS_READ
+  asm volatile("mov r0, %2 \n" // assign r0 = incr
+               "svc %1     \n" // make system call SYS_SBRK
                "mov %0, r0 \n" // assign r  = r0
                : "=r"(r)
-               : "I"(SYS_SEM_INIT)
+               : "I"(SYS_SBRK), "r"(incr)
                : "r0");
 
   return r;
 }
 
+//  arena of the calling process (the kernel loads TPIDRURO with its heap base, 0 until the first sbrk)
+malloc_arena_t *mallocArena()
+{
+  malloc_arena_t *arena;
+
+  asm volatile("mrc p15, 0, %0, c13, c0, 3 \n" // read TPIDRURO
+               : "=r"(arena));
+
+  if (arena == NULL)
+  {
+    //  create the heap, with the arena at its base (padded so blocks stay 8-byte aligned)
+    arena = sbrk((sizeof(malloc_arena_t) + 7) & ~7);
+    if (arena == (void *)-1)
+    {
+      return NULL;
+    }
+    memset(arena, 0, sizeof(malloc_arena_t));
+  }
+  return arena;
+}
+
+//  carve n bytes from the memory obtained from sbrk, extending it if needed (NULL if the heap is full)
+void *mallocCarve(malloc_arena_t *arena, uint32_t n)
+{
+  if (arena->top == NULL || arena->top + n > arena->end)
+  {
+    uint32_t chunk = (n > MALLOC_CHUNK) ? n : MALLOC_CHUNK;
+    uint8_t *x = sbrk(chunk);
+    if (x == (void *)-1)
+    {
+      return NULL;
+    }
+    //  the break is contiguous, so a new chunk normally just extends the current one
+    if (x != arena->end)
+    {
+      arena->top = x;
+    }
+    arena->end = x + chunk;
+  }
+  void *r = arena->top;
+  arena->top += n;
+  return r;
+}
+
+//  allocate at least size bytes (8-byte aligned); only traps into the kernel to grow the heap
+void *mallocLocal(size_t size)
+{
+  malloc_arena_t *arena = mallocArena();
+  if (arena == NULL)
+  {
+    return NULL;
+  }
+
+  uint32_t n = size + sizeof(malloc_header_t);
+  int class = 0;
+  while (class < MALLOC_CLASSES && (MALLOC_MIN << class) < n)
+  {
+    class++;
+  }
+
+  malloc_header_t *header = NULL;
+  if (class < MALLOC_CLASSES)
+  {
+    n = MALLOC_MIN << class;
+    //  refill the (empty) free list with a batch of blocks
+    if (arena->freeLists[class] == NULL)
+    {
+      for (int i = 0; i < MALLOC_BATCH; i++)
+      {
+        malloc_block_t *block = mallocCarve(arena, n);
+        if (block == NULL)
+        {
+          break;
+        }
+        block->next = arena->freeLists[class];
+        arena->freeLists[class] = block;
+      }
+    }
+    header = (malloc_header_t *)arena->freeLists[class];
+    if (header != NULL)
+    {
+      arena->freeLists[class] = arena->freeLists[class]->next;
+    }
+  }
+  else
+  {
+    //  first fit from the freed large blocks (linked through their payloads), else carve a new one
+    n = (n + 0xFFF) & ~0xFFF;
+    malloc_block_t **prev = &arena->large;
+    for (malloc_block_t *block = arena->large; block != NULL; prev = &block->next, block = block->next)
+    {
+      malloc_header_t *h = (malloc_header_t *)block - 1;
+      if (h->size >= n)
+      {
+        *prev = block->next;
+        header = h;
+        n = h->size;
+        break;
+      }
+    }
+    if (header == NULL)
+    {
+      header = mallocCarve(arena, n);
+    }
+  }
+
+  if (header == NULL)
+  {
+    return NULL;
+  }
+  header->size = n;
+  header->class = class;
+  return header + 1;
+}
+
+//  allocate n zeroed elements of the given size
+void *callocLocal(size_t n, size_t size)
+{
+  void *r = mallocLocal(n * size);
+  if (r != NULL)
+  {
+    memset(r, 0, n * size);
+  }
+  return r;
+}
+
+//  resize an allocation (in place if its block is already big enough)
+void *reallocLocal(void *x, size_t size)
+{
+  if (x == NULL)
+  {
+    return mallocLocal(size);
+  }
+  malloc_header_t *header = (malloc_header_t *)x - 1;
+  uint32_t capacity = header->size - sizeof(malloc_header_t);
+  if (size <= capacity)
+  {
+    return x;
+  }
+  void *r = mallocLocal(size);
+  if (r != NULL)
+  {
+    memcpy(r, x, capacity);
+    freeLocal(x);
+  }
+  return r;
+}
+
+//  return a block to the free list of its size class
+void freeLocal(void *x)
+{
+  if (x == NULL)
+  {
+    return;
+  }
+  malloc_arena_t *arena = mallocArena();
+  malloc_header_t *header = (malloc_header_t *)x - 1;
+  uint32_t class = header->class;
+
+  if (class < MALLOC_CLASSES)
+  {
+    //  the size class is implied by the list, so the link can overwrite the header
+    malloc_block_t *block = (malloc_block_t *)header;
+    block->next = arena->freeLists[class];
+    arena->freeLists[class] = block;
+  }
+  else
+  {
+    //  large blocks keep their header (for the size) and link through the payload
+    malloc_block_t *block = (malloc_block_t *)x;
+    block->next = arena->large;
+    arena->large = block;
+  }
+  return;
+}
+
+//  initialise an empty (0) semaphore
+int sem_init(sem_t *sem)
+{
+  int r;
+
+  asm volatile("mov r0, %2 \n" // assign r0 = sem
+               "svc %1     \n" // make system call SYS_SEM_INIT
+               "mov %0, r0 \n" // assign r  = r0
+               : "=r"(r)
+               : "I"(SYS_SEM_INIT), "r"(sem)
+               : "r0");
+
+  sem->handle = r;
+  sem->acquired = 0;
+  return (r < 0) ? -1 : 0;
+}
+
 //  destroys (frees) semaphore
-void sem_destroy(sem_t sem)
+void sem_destroy(sem_t *sem)
 {
-  asm volatile("mov r0, %1 \n" // assign r0 = x
-               "svc %0     \n" // make system call SYS_EXEC
+  asm volatile("mov r0, %1 \n" // assign r0 = handle
+               "svc %0     \n" // make system call SYS_SEM_DESTROY
                :
-               : "I"(SYS_SEM_DESTROY), "r"(sem)
+               : "I"(SYS_SEM_DESTROY), "r"(sem->handle)
                : "r0");
 
   return;
 }
 
-//  post to semaphore (increment by 1)
-void sem_post(sem_t sem)
+//  post to semaphore (increment by 1); only enters the kernel if a process is waiting
+void sem_post(sem_t *sem)
 {
-  asm volatile("mov r0, %1 \n" // assign r0 = x
-               "svc %0     \n" // make system call SYS_EXEC
+  int v = sem->value;
+  while (v >= 0)
+  {
+    int seen = atomicCas(&sem->value, v, v + 1);
+    if (seen == v)
+    {
+      return;
+    }
+    v = seen;
+  }
+
+  asm volatile("mov r0, %1 \n" // assign r0 = handle
+               "svc %0     \n" // make system call SYS_SEM_POST
                :
-               : "I"(SYS_SEM_POST), "r"(*sem)
+               : "I"(SYS_SEM_POST), "r"(sem->handle)
                : "r0");
 
   return;
 }
 
-//  same as POSIX sem_wait (decrement if >0 and return *sem, if <0 return -1, if *sem = 0 return 0)
-int sem_wait(sem_t sem)
+//  same as POSIX sem_wait (decrement if >0, else block until posted; return 0, or -1 on error or if sem is destroyed)
+int sem_wait(sem_t *sem)
 {
   int r;
+  int v = sem->value;
 
-  asm volatile("mov r0, %2 \n" // assign r0 = fd
-               "svc %1     \n" // make system call SYS_READ
+  //  fast path: take a unit without entering the kernel
+  while (v > 0)
+  {
+    int seen = atomicCas(&sem->value, v, v - 1);
+    if (seen == v)
+    {
+#ifdef KERNEL_LOCK_STATS
+      sem->acquired++;
+#endif
+      return 0;
+    }
+    v = seen;
+  }
+
+  asm volatile("mov r0, %2 \n" // assign r0 = handle
+               "svc %1     \n" // make system call SYS_SEM_WAIT
                "mov %0, r0 \n" // assign r  = r0
                : "=r"(r)
-               : "I"(SYS_SEM_WAIT), "r"(sem)
+               : "I"(SYS_SEM_WAIT), "r"(sem->handle)
                : "r0");
 
-  while (r == 0)
+  return r;
+}
+
+//  always a system call: the kernel must see every semaphore of the vector at once
+int semop(sembuf_t *ops, int n)
+{
+  int r;
+
+  asm volatile("mov r0, %2 \n" // assign r0 = ops
+               "mov r1, %3 \n" // assign r1 =   n
+               "svc %1     \n" // make system call SYS_SEMOP
+               "mov %0, r0 \n" // assign r  = r0
+               : "=r"(r)
+               : "I"(SYS_SEMOP), "r"(ops), "r"(n)
+               : "r0", "r1", "memory");
+
+  return r;
+}
+
+int atomicCas(int *addr, int expected, int desired)
+{
+  int seen, failed;
+
+  asm volatile("1: ldrex %0, [%2]     \n" // seen = *addr, claiming the exclusive monitor
+               "   cmp   %0, %3       \n"
+               "   bne   2f           \n" // give up if seen != expected
+               "   strex %1, %4, [%2] \n" // *addr = desired, unless the monitor was lost (failed = 1)
+               "   cmp   %1, #0       \n"
+               "   bne   1b           \n"
+               "2:                    \n"
+               : "=&r"(seen), "=&r"(failed)
+               : "r"(addr), "r"(expected), "r"(desired)
+               : "cc", "memory");
+
+  return seen;
+}
+
+int atomicAdd(int *addr, int x)
+{
+  int old, failed;
+
+  asm volatile("1: ldrex %0, [%2]     \n" // old = *addr
+               "   add   %1, %0, %3   \n"
+               "   strex %1, %1, [%2] \n" // *addr = old + x, unless the monitor was lost
+               "   cmp   %1, #0       \n"
+               "   bne   1b           \n"
+               : "=&r"(old), "=&r"(failed)
+               : "r"(addr), "r"(x)
+               : "cc", "memory");
+
+  return old;
+}
+
+int atomicSwap(int *addr, int x)
+{
+  int old, failed;
+
+  asm volatile("1: ldrex %0, [%2]     \n" // old = *addr
+               "   strex %1, %3, [%2] \n" // *addr = x, unless the monitor was lost
+               "   cmp   %1, #0       \n"
+               "   bne   1b           \n"
+               : "=&r"(old), "=&r"(failed)
+               : "r"(addr), "r"(x)
+               : "cc", "memory");
+
+  return old;
+}
+
+int futex_wait(int *addr, int expected)
+{
+  int r;
+
+  asm volatile("mov r0, %2 \n" // assign r0 =     addr
+               "mov r1, %3 \n" // assign r1 = expected
+               "svc %1     \n" // make system call SYS_FUTEX_WAIT
+               "mov %0, r0 \n" // assign r  = r0
+               : "=r"(r)
+               : "I"(SYS_FUTEX_WAIT), "r"(addr), "r"(expected)
+               : "r0", "r1");
+
+  return r;
+}
+
+int futex_wake(int *addr, int n)
+{
+  int r;
+
+  asm volatile("mov r0, %2 \n" // assign r0 = addr
+               "mov r1, %3 \n" // assign r1 =    n
+               "svc %1     \n" // make system call SYS_FUTEX_WAKE
+               "mov %0, r0 \n" // assign r  = r0
+               : "=r"(r)
+               : "I"(SYS_FUTEX_WAKE), "r"(addr), "r"(n)
+               : "r0", "r1");
+
+  return r;
+}
+
+void mutex_init(mutex_t *mutex)
+{
+  *mutex = MUTEX_INITIALIZER;
+}
+
+//  lock: 0 -> 1 without entering the kernel; if already locked, mark it contended (2) and sleep until unlocked
+void mutex_lock(mutex_t *mutex)
+{
+  int c = atomicCas(mutex, 0, 1);
+  if (c == 0)
   {
-    r = *sem;
+    return;
   }
-  return r;
+  if (c != 2)
+  {
+    c = atomicSwap(mutex, 2);
+  }
+  while (c != 0)
+  {
+    futex_wait(mutex, 2);
+    c = atomicSwap(mutex, 2);
+  }
+  return;
 }
 
-//  allocate shared memory space of given size
-void *shm_init(size_t size)
+//  returns true if the mutex was free (and is now locked by the caller)
+bool mutex_trylock(mutex_t *mutex)
 {
-  void *r;
+  return atomicCas(mutex, 0, 1) == 0;
+}
 
-  asm volatile("mov r0, %2 \n" // assign r0 = fd
-               "svc %1     \n" // make system call SYS_READ
+//  unlock, entering the kernel only if the mutex was contended
+void mutex_unlock(mutex_t *mutex)
+{
+  if (atomicSwap(mutex, 0) == 2)
+  {
+    futex_wake(mutex, 1);
+  }
+  return;
+}
+
+kmutex_t kmutex_init()
+{
+  kmutex_t r;
+
+  asm volatile("svc %1     \n" // make system call SYS_KMUTEX_INIT
                "mov %0, r0 \n" // assign r  = r0
                : "=r"(r)
-               : "I"(SYS_SHM_INIT), "r"(size)
+               : "I"(SYS_KMUTEX_INIT)
                : "r0");
 
   return r;
 }
 
-//  free shared memory space "shm"
-//  if pid = owner remove from shmTable, defrag, resize?, free
-void shm_destroy(void *addr)
+void kmutex_destroy(kmutex_t mutex)
 {
-  asm volatile("mov r0, %1 \n" // assign r0 =  addr
-               "svc %0     \n" // make system call SYS_KILL
+  asm volatile("mov r0, %1 \n" // assign r0 = mutex
+               "svc %0     \n" // make system call SYS_KMUTEX_DESTROY
                :
-               : "I"(SYS_SHM_DESTROY), "r"(addr)
+               : "I"(SYS_KMUTEX_DESTROY), "r"(mutex)
                : "r0");
 
   return;
 }
 
-//  atomic write to shared memory space
-void shm_write(void *addr, int data, size_t dataSize)
+int kmutex_lock(kmutex_t mutex)
+{
+  int r;
+
+  asm volatile("mov r0, %2 \n" // assign r0 = mutex
+               "svc %1     \n" // make system call SYS_KMUTEX_LOCK
+               "mov %0, r0 \n" // assign r  = r0
+               : "=r"(r)
+               : "I"(SYS_KMUTEX_LOCK), "r"(mutex)
+               : "r0");
+
+  return r;
+}
+
+int kmutex_unlock(kmutex_t mutex)
+{
+  int r;
+
+  asm volatile("mov r0, %2 \n" // assign r0 = mutex
+               "svc %1     \n" // make system call SYS_KMUTEX_UNLOCK
+               "mov %0, r0 \n" // assign r  = r0
+               : "=r"(r)
+               : "I"(SYS_KMUTEX_UNLOCK), "r"(mutex)
+               : "r0");
+
+  return r;
+}
+
+cond_t cond_init()
+{
+  cond_t r;
+
+  asm volatile("svc %1     \n" // make system call SYS_COND_INIT
+               "mov %0, r0 \n" // assign r  = r0
+               : "=r"(r)
+               : "I"(SYS_COND_INIT)
+               : "r0");
+
+  return r;
+}
+
+void cond_destroy(cond_t cond)
 {
-  asm volatile("mov r0, %1 \n" // assign r0 =  addr
-               "mov r1, %2 \n" // assign r1 =  addr
-               "mov r2, %3 \n" // assign r2 =   pid
-               "svc %0     \n" // make system call SYS_KILL
+  asm volatile("mov r0, %1 \n" // assign r0 = cond
+               "svc %0     \n" // make system call SYS_SYNC_DESTROY
                :
-               : "I"(SYS_SHM_WRITE), "r"(addr), "r"(data), "r"(dataSize)
-               : "r0", "r1", "r2");
+               : "I"(SYS_SYNC_DESTROY), "r"(cond)
+               : "r0");
 
   return;
 }
+
+//  atomically unlock mutex and wait for cond to be signalled, then re-lock mutex (waits may wake spuriously)
+int cond_wait(cond_t cond, mutex_t *mutex)
+{
+  int r;
+
+  asm volatile("mov r0, %2 \n" // assign r0 =  cond
+               "mov r1, %3 \n" // assign r1 = mutex
+               "svc %1     \n" // make system call SYS_COND_WAIT
+               "mov %0, r0 \n" // assign r  = r0
+               : "=r"(r)
+               : "I"(SYS_COND_WAIT), "r"(cond), "r"(mutex)
+               : "r0", "r1");
+
+  mutex_lock(mutex);
+  return r;
+}
+
+int cond_signal(cond_t cond)
+{
+  int r;
+
+  asm volatile("mov r0, %2 \n" // assign r0 = cond
+               "svc %1     \n" // make system call SYS_COND_SIGNAL
+               "mov %0, r0 \n" // assign r  = r0
+               : "=r"(r)
+               : "I"(SYS_COND_SIGNAL), "r"(cond)
+               : "r0");
+
+  return r;
+}
+
+int cond_broadcast(cond_t cond)
+{
+  int r;
+
+  asm volatile("mov r0, %2 \n" // assign r0 = cond
+               "svc %1     \n" // make system call SYS_COND_BROADCAST
+               "mov %0, r0 \n" // assign r  = r0
+               : "=r"(r)
+               : "I"(SYS_COND_BROADCAST), "r"(cond)
+               : "r0");
+
+  return r;
+}
+
+barrier_t barrier_init(int parties)
+{
+  barrier_t r;
+
+  asm volatile("mov r0, %2 \n" // assign r0 = parties
+               "svc %1     \n" // make system call SYS_BARRIER_INIT
+               "mov %0, r0 \n" // assign r  = r0
+               : "=r"(r)
+               : "I"(SYS_BARRIER_INIT), "r"(parties)
+               : "r0");
+
+  return r;
+}
+
+void barrier_destroy(barrier_t barrier)
+{
+  asm volatile("mov r0, %1 \n" // assign r0 = barrier
+               "svc %0     \n" // make system call SYS_SYNC_DESTROY
+               :
+               : "I"(SYS_SYNC_DESTROY), "r"(barrier)
+               : "r0");
+
+  return;
+}
+
+int barrier_wait(barrier_t barrier)
+{
+  int r;
+
+  asm volatile("mov r0, %2 \n" // assign r0 = barrier
+               "svc %1     \n" // make system call SYS_BARRIER_WAIT
+               "mov %0, r0 \n" // assign r  = r0
+               : "=r"(r)
+               : "I"(SYS_BARRIER_WAIT), "r"(barrier)
+               : "r0");
+
+  return r;
+}
+
+rwlock_t rwlock_init()
+{
+  rwlock_t r;
+
+  asm volatile("svc %1     \n" // make system call SYS_RWLOCK_INIT
+               "mov %0, r0 \n" // assign r  = r0
+               : "=r"(r)
+               : "I"(SYS_RWLOCK_INIT)
+               : "r0");
+
+  return r;
+}
+
+void rwlock_destroy(rwlock_t rwlock)
+{
+  asm volatile("mov r0, %1 \n" // assign r0 = rwlock
+               "svc %0     \n" // make system call SYS_SYNC_DESTROY
+               :
+               : "I"(SYS_SYNC_DESTROY), "r"(rwlock)
+               : "r0");
+
+  return;
+}
+
+int rwlock_rdlock(rwlock_t rwlock)
+{
+  int r;
+
+  asm volatile("mov r0, %2 \n" // assign r0 = rwlock
+               "svc %1     \n" // make system call SYS_RWLOCK_RDLOCK
+               "mov %0, r0 \n" // assign r  = r0
+               : "=r"(r)
+               : "I"(SYS_RWLOCK_RDLOCK), "r"(rwlock)
+               : "r0");
+
+  return r;
+}
+
+int rwlock_wrlock(rwlock_t rwlock)
+{
+  int r;
+
+  asm volatile("mov r0, %2 \n" // assign r0 = rwlock
+               "svc %1     \n" // make system call SYS_RWLOCK_WRLOCK
+               "mov %0, r0 \n" // assign r  = r0
+               : "=r"(r)
+               : "I"(SYS_RWLOCK_WRLOCK), "r"(rwlock)
+               : "r0");
+
+  return r;
+}
+
+int rwlock_unlock(rwlock_t rwlock)
+{
+  int r;
+
+  asm volatile("mov r0, %2 \n" // assign r0 = rwlock
+               "svc %1     \n" // make system call SYS_RWLOCK_UNLOCK
+               "mov %0, r0 \n" // assign r  = r0
+               : "=r"(r)
+               : "I"(SYS_RWLOCK_UNLOCK), "r"(rwlock)
+               : "r0");
+
+  return r;
+}
+
+pipe_t pipe_init(size_t size)
+{
+  int r;
+
+  asm volatile("mov r0, %2 \n" // assign r0 = size
+               "svc %1     \n" // make system call SYS_PIPE_INIT
+               "mov %0, r0 \n" // assign r  = r0
+               : "=r"(r)
+               : "I"(SYS_PIPE_INIT), "r"(size)
+               : "r0");
+
+  return r;
+}
+
+//  pipes and channels share SYS_PIPE_DESTROY
+void pipe_destroy(pipe_t pipe)
+{
+  asm volatile("mov r0, %1 \n" // assign r0 = pipe
+               "svc %0     \n" // make system call SYS_PIPE_DESTROY
+               :
+               : "I"(SYS_PIPE_DESTROY), "r"(pipe)
+               : "r0");
+
+  return;
+}
+
+//  one system call each; the kernel restarts a blocked send or recv itself, so r is final
+int ipc_send(int pipe, const void *x, size_t n, int flags)
+{
+  int r;
+
+  asm volatile("mov r0, %2 \n" // assign r0 =  pipe
+               "mov r1, %3 \n" // assign r1 =     x
+               "mov r2, %4 \n" // assign r2 =     n
+               "mov r3, %5 \n" // assign r3 = flags
+               "svc %1     \n" // make system call SYS_IPC_SEND
+               "mov %0, r0 \n" // assign r  = r0
+               : "=r"(r)
+               : "I"(SYS_IPC_SEND), "r"(pipe), "r"(x), "r"(n), "r"(flags)
+               : "r0", "r1", "r2", "r3");
+
+  return r;
+}
+
+int ipc_recv(int pipe, void *x, size_t n, int flags)
+{
+  int r;
+
+  asm volatile("mov r0, %2 \n" // assign r0 =  pipe
+               "mov r1, %3 \n" // assign r1 =     x
+               "mov r2, %4 \n" // assign r2 =     n
+               "mov r3, %5 \n" // assign r3 = flags
+               "svc %1     \n" // make system call SYS_IPC_RECV
+               "mov %0, r0 \n" // assign r  = r0
+               : "=r"(r)
+               : "I"(SYS_IPC_RECV), "r"(pipe), "r"(x), "r"(n), "r"(flags)
+               : "r0", "r1", "r2", "r3");
+
+  return r;
+}
+
+int pipe_write(pipe_t pipe, const void *x, size_t n, int flags)
+{
+  int r = ipc_send(pipe, x, n, flags);
+
+  //  a blocking write finishes with the bytes moved by its last (restarted) step
+  return (r >= 0 && !(flags & IPC_NONBLOCK)) ? (int)n : r;
+}
+
+int pipe_read(pipe_t pipe, void *x, size_t n, int flags)
+{
+  return ipc_recv(pipe, x, n, flags);
+}
+
+chan_t chan_init(size_t msgSize, int slots)
+{
+  int r;
+
+  asm volatile("mov r0, %2 \n" // assign r0 = msgSize
+               "mov r1, %3 \n" // assign r1 =   slots
+               "svc %1     \n" // make system call SYS_CHAN_INIT
+               "mov %0, r0 \n" // assign r  = r0
+               : "=r"(r)
+               : "I"(SYS_CHAN_INIT), "r"(msgSize), "r"(slots)
+               : "r0", "r1");
+
+  return r;
+}
+
+int chan_send(chan_t chan, const void *msg, int flags)
+{
+  return ipc_send(chan, msg, 0, flags);
+}
+
+int chan_recv(chan_t chan, void *msg, int flags)
+{
+  return ipc_recv(chan, msg, 0, flags);
+}
+
+int poll(pollfd_t *fds, int n, int timeout)
+{
+  int r;
+
+  asm volatile("mov r0, %2 \n" // assign r0 =     fds
+               "mov r1, %3 \n" // assign r1 =       n
+               "mov r2, %4 \n" // assign r2 = timeout
+               "svc %1     \n" // make system call SYS_POLL
+               "mov %0, r0 \n" // assign r  = r0
+               : "=r"(r)
+               : "I"(SYS_POLL), "r"(fds), "r"(n), "r"(timeout)
+               : "r0", "r1", "r2", "memory");
+
+  return r;
+}
+
+pollset_t pollset_init()
+{
+  int r;
+
+  asm volatile("svc %1     \n" // make system call SYS_POLLSET_INIT
+               "mov %0, r0 \n" // assign r  = r0
+               : "=r"(r)
+               : "I"(SYS_POLLSET_INIT)
+               : "r0");
+
+  return r;
+}
+
+void pollset_destroy(pollset_t set)
+{
+  asm volatile("mov r0, %1 \n" // assign r0 = set
+               "svc %0     \n" // make system call SYS_POLLSET_DESTROY
+               :
+               : "I"(SYS_POLLSET_DESTROY), "r"(set)
+               : "r0");
+
+  return;
+}
+
+int pollset_ctl(pollset_t set, int op, int handle, int events)
+{
+  int r;
+
+  asm volatile("mov r0, %2 \n" // assign r0 =    set
+               "mov r1, %3 \n" // assign r1 =     op
+               "mov r2, %4 \n" // assign r2 = handle
+               "mov r3, %5 \n" // assign r3 = events
+               "svc %1     \n" // make system call SYS_POLLSET_CTL
+               "mov %0, r0 \n" // assign r  = r0
+               : "=r"(r)
+               : "I"(SYS_POLLSET_CTL), "r"(set), "r"(op), "r"(handle), "r"(events)
+               : "r0", "r1", "r2", "r3");
+
+  return r;
+}
+
+int pollset_wait(pollset_t set, pollfd_t *out, int max, int timeout)
+{
+  int r;
+
+  asm volatile("mov r0, %2 \n" // assign r0 =     set
+               "mov r1, %3 \n" // assign r1 =     out
+               "mov r2, %4 \n" // assign r2 =     max
+               "mov r3, %5 \n" // assign r3 = timeout
+               "svc %1     \n" // make system call SYS_POLLSET_WAIT
+               "mov %0, r0 \n" // assign r  = r0
+               : "=r"(r)
+               : "I"(SYS_POLLSET_WAIT), "r"(set), "r"(out), "r"(max), "r"(timeout)
+               : "r0", "r1", "r2", "r3", "memory");
+
+  return r;
+}
+
+//  the message is loaded into r1-r8 through ip, which the kernel preserves, and stored back from them
+int ipc_call(pid_t dest, ipc_msg_t *msg)
+{
+  int r;
+
+  asm volatile("mov r0, %2         \n" // assign r0 = dest
+               "mov ip, %3         \n" // assign ip = msg
+               "ldmia ip, { r1-r8 } \n" // assign r1-r8 = msg->w
+               "svc %1             \n" // make system call SYS_IPC_CALL
+               "stmia ip, { r1-r8 } \n" // assign msg->w = r1-r8
+               "mov %0, r0         \n" // assign r  = r0
+               : "=r"(r)
+               : "I"(SYS_IPC_CALL), "r"(dest), "r"(msg)
+               : "r0", "r1", "r2", "r3", "r4", "r5", "r6", "r7", "r8", "ip", "memory");
+
+  return r;
+}
+
+pid_t ipc_reply_wait(pid_t replyTo, ipc_msg_t *msg)
+{
+  pid_t r;
+
+  asm volatile("mov r0, %2         \n" // assign r0 = replyTo
+               "mov ip, %3         \n" // assign ip = msg
+               "ldmia ip, { r1-r8 } \n" // assign r1-r8 = msg->w
+               "svc %1             \n" // make system call SYS_IPC_REPLY_WAIT
+               "stmia ip, { r1-r8 } \n" // assign msg->w = r1-r8
+               "mov %0, r0         \n" // assign r  = r0
+               : "=r"(r)
+               : "I"(SYS_IPC_REPLY_WAIT), "r"(replyTo), "r"(msg)
+               : "r0", "r1", "r2", "r3", "r4", "r5", "r6", "r7", "r8", "ip", "memory");
+
+  return r;
+}
+
+//  open or create the shared memory segment named key
+int shm_open(int key, size_t size, void **addr)
+{
+  int r;
+  void *x;
+
+  asm volatile("mov r0, %3 \n" // assign r0 =  key
+               "mov r1, %4 \n" // assign r1 = size
+               "svc %2     \n" // make system call SYS_SHM_OPEN
+               "mov %0, r0 \n" // assign r  = r0 (handle)
+               "mov %1, r1 \n" // assign x  = r1 (address)
+               : "=r"(r), "=r"(x)
+               : "I"(SYS_SHM_OPEN), "r"(key), "r"(size)
+               : "r0", "r1");
+
+  *addr = x;
+  return r;
+}
+
+void *shm_attach(int shm)
+{
+  void *r;
+
+  asm volatile("mov r0, %2 \n" // assign r0 = shm
+               "svc %1     \n" // make system call SYS_SHM_ATTACH
+               "mov %0, r0 \n" // assign r  = r0
+               : "=r"(r)
+               : "I"(SYS_SHM_ATTACH), "r"(shm)
+               : "r0");
+
+  return r;
+}
+
+int shm_detach(int shm)
+{
+  int r;
+
+  asm volatile("mov r0, %2 \n" // assign r0 = shm
+               "svc %1     \n" // make system call SYS_SHM_DETACH
+               "mov %0, r0 \n" // assign r  = r0
+               : "=r"(r)
+               : "I"(SYS_SHM_DETACH), "r"(shm)
+               : "r0");
+
+  return r;
+}
+
+int fd_open(int kind, int arg)
+{
+  int r;
+
+  asm volatile("mov r0, %2 \n" // assign r0 = kind
+               "mov r1, %3 \n" // assign r1 =  arg
+               "svc %1     \n" // make system call SYS_FD_OPEN
+               "mov %0, r0 \n" // assign r  = r0
+               : "=r"(r)
+               : "I"(SYS_FD_OPEN), "r"(kind), "r"(arg)
+               : "r0", "r1");
+
+  return r;
+}
+
+int fd_close(int fd)
+{
+  int r;
+
+  asm volatile("mov r0, %2 \n" // assign r0 = fd
+               "svc %1     \n" // make system call SYS_FD_CLOSE
+               "mov %0, r0 \n" // assign r  = r0
+               : "=r"(r)
+               : "I"(SYS_FD_CLOSE), "r"(fd)
+               : "r0");
+
+  return r;
+}
+
+int dup2(int oldfd, int newfd)
+{
+  int r;
+
+  asm volatile("mov r0, %2 \n" // assign r0 = oldfd
+               "mov r1, %3 \n" // assign r1 = newfd
+               "svc %1     \n" // make system call SYS_DUP2
+               "mov %0, r0 \n" // assign r  = r0
+               : "=r"(r)
+               : "I"(SYS_DUP2), "r"(oldfd), "r"(newfd)
+               : "r0", "r1");
+
+  return r;
+}
+
+int fd_seek(int fd, size_t offset)
+{
+  int r;
+
+  asm volatile("mov r0, %2 \n" // assign r0 =     fd
+               "mov r1, %3 \n" // assign r1 = offset
+               "svc %1     \n" // make system call SYS_FD_SEEK
+               "mov %0, r0 \n" // assign r  = r0
+               : "=r"(r)
+               : "I"(SYS_FD_SEEK), "r"(fd), "r"(offset)
+               : "r0", "r1");
+
+  return r;
+}
+
+int disk_set_mode(int mode)
+{
+  int r;
+
+  asm volatile("mov r0, %2 \n" // assign r0 = mode
+               "svc %1     \n" // make system call SYS_DISK_SET_MODE
+               "mov %0, r0 \n" // assign r  = r0
+               : "=r"(r)
+               : "I"(SYS_DISK_SET_MODE), "r"(mode)
+               : "r0");
+
+  return r;
+}
+
+int io_setup(io_ring_t *ring)
+{
+  int r;
+
+  asm volatile("mov r0, %2 \n" // assign r0 = ring
+               "svc %1     \n" // make system call SYS_IO_SETUP
+               "mov %0, r0 \n" // assign r  = r0
+               : "=r"(r)
+               : "I"(SYS_IO_SETUP), "r"(ring)
+               : "r0", "memory");
+
+  return r;
+}
+
+int io_enter(int minComplete)
+{
+  int r;
+
+  asm volatile("mov r0, %2 \n" // assign r0 = minComplete
+               "svc %1     \n" // make system call SYS_IO_ENTER
+               "mov %0, r0 \n" // assign r  = r0
+               : "=r"(r)
+               : "I"(SYS_IO_ENTER), "r"(minComplete)
+               : "r0", "memory");
+
+  return r;
+}
+
+bool io_submit(io_ring_t *ring, int op, int fd, void *buf, uint32_t len, uint32_t userData)
+{
+  uint32_t tail = ring->sqTail;
+
+  if (tail - ring->sqHead == ring->entries)
+  {
+    return false;
+  }
+  io_sqe_t *sqe = &ring->sq[tail & (ring->entries - 1)];
+  sqe->op = op;
+  sqe->fd = fd;
+  sqe->buf = buf;
+  sqe->len = len;
+  sqe->userData = userData;
+  //  the entry is filled before the kernel (with IORING_SQPOLL, at any interrupt) can see it
+  asm volatile("" ::: "memory");
+  ring->sqTail = tail + 1;
+  return true;
+}
+
+bool io_reap(io_ring_t *ring, io_cqe_t *cqe)
+{
+  uint32_t head = ring->cqHead;
+
+  if (head == ring->cqTail)
+  {
+    return false;
+  }
+  *cqe = ring->cq[head & (ring->entries - 1)];
+  ring->cqHead = head + 1;
+  return true;
+}
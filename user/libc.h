@@ -39,11 +39,18 @@ typedef int pid_t;
 #define SYS_PRIO (0x07) //   TODO increase priority in scheduler
 #define SYS_PAUSE (0x08)
 #define SYS_UNPAUSE (0x09)
+#define SYS_HANDOFF (0x0A)
 #define SYS_STATUS (0x10)
 #define SYS_HISTORY (0x11)
 #define SYS_CLOSE (0x12)
 #define SYS_FORKPROC (0x13)
 #define SYS_GETADDR (0x14)
+#define SYS_SLABS (0x15)
+#define SYS_PAGES (0x16)
+#define SYS_BRK (0x17)
+#define SYS_SBRK (0x18)
+#define SYS_MEMSTAT (0x19)
+#define SYS_LOCKSTAT (0x1A)
 
 #define EXIT_SUCCESS 0 //EXIT W SUCCESS
 #define EXIT_FAILURE 1 //EXIT W FAILURE (LOG PCB ENTRY IN procTableHistory)
@@ -51,23 +58,257 @@ typedef int pid_t;
 #define STDIN_FILENO (0)
 #define STDOUT_FILENO (1)
 #define STDERR_FILENO (2)
+//  the console's terminal (UART1), read a line at a time
+#define CONSOLE_FILENO (3)
 
-#define SYS_SHM_INIT (0x20)
-#define SYS_SHM_DESTROY (0x21)
-#define SYS_SHM_WRITE (0x22)
+//  kinds of object fd_open opens a descriptor on (with its argument)
+#define FILE_UART (1) // UART number: 0 (standard output) or 1 (the console's terminal)
+#define FILE_PIPE (2) // pipe or channel handle
+#define FILE_SHM (3)  // shared memory segment handle (read and written from offset 0)
+#define FILE_DISK (4) // first disk block (read and written from offset 0)
+#define FILE_NULL (5) // none: writes are discarded, reads return 0
+
+#define SYS_SHM_OPEN (0x20)
+#define SYS_SHM_DETACH (0x21)
+#define SYS_SHM_ATTACH (0x22)
+
+#define SHM_PRIVATE (0) // shm_open key: always a new segment
 
 #define SYS_SEM_INIT (0x30)
 #define SYS_SEM_DESTROY (0x31)
 #define SYS_SEM_POST (0x32)
 #define SYS_SEM_WAIT (0x33)
+#define SYS_FUTEX_WAIT (0x34)
+#define SYS_FUTEX_WAKE (0x35)
+#define SYS_KMUTEX_INIT (0x36)
+#define SYS_KMUTEX_DESTROY (0x37)
+#define SYS_KMUTEX_LOCK (0x38)
+#define SYS_KMUTEX_UNLOCK (0x39)
+#define SYS_SEMOP (0x3A)
+
+#define SYS_COND_INIT (0x40)
+#define SYS_COND_WAIT (0x41)
+#define SYS_COND_SIGNAL (0x42)
+#define SYS_COND_BROADCAST (0x43)
+#define SYS_BARRIER_INIT (0x44)
+#define SYS_BARRIER_WAIT (0x45)
+#define SYS_RWLOCK_INIT (0x46)
+#define SYS_RWLOCK_RDLOCK (0x47)
+#define SYS_RWLOCK_WRLOCK (0x48)
+#define SYS_RWLOCK_UNLOCK (0x49)
+#define SYS_SYNC_DESTROY (0x4A)
+
+#define SYS_PIPE_INIT (0x50)
+#define SYS_CHAN_INIT (0x51)
+#define SYS_IPC_SEND (0x52)
+#define SYS_IPC_RECV (0x53)
+#define SYS_PIPE_DESTROY (0x54)
+
+#define PIPE_SIZE (0x1000) // default pipe capacity in bytes
+#define IPC_NONBLOCK (1)   // flag: fail with IPC_AGAIN instead of blocking
+#define IPC_AGAIN (-2)
+
+#define SYS_IPC_CALL (0x58)
+#define SYS_IPC_REPLY_WAIT (0x59)
+
+#define SYS_POLL (0x5A)
+#define SYS_POLLSET_INIT (0x5B)
+#define SYS_POLLSET_CTL (0x5C)
+#define SYS_POLLSET_WAIT (0x5D)
+#define SYS_POLLSET_DESTROY (0x5E)
+
+#define SYS_FD_OPEN (0x60)
+#define SYS_FD_CLOSE (0x61)
+#define SYS_DUP2 (0x62)
+#define SYS_FD_SEEK (0x63)
+#define SYS_IO_SETUP (0x64)
+#define SYS_IO_ENTER (0x65)
+#define SYS_DISK_SET_MODE (0x66)
+
+#define DISK_HEX (1) // disk protocol: lines of hex digits (what any disk speaks)
+#define DISK_BIN (2) // disk protocol: binary frames with CRCs
+
+#define IORING_OP_NOP (0)   // complete at once with res 0
+#define IORING_OP_READ (1)  // read  up to len bytes from fd into buf (once any are ready)
+#define IORING_OP_WRITE (2) // write len bytes from buf to fd (as room appears)
+#define IORING_SQPOLL (1)   // ring flag: the kernel also takes submissions on its own, every tick
+
+#define POLLIN (0x0001)  // readable (data in a pipe or channel); for a semaphore, taken
+#define POLLOUT (0x0002) // writable (room in a pipe or channel)
+#define POLLERR (0x0004) // not a live handle (always reported)
+#define POLLET (0x8000)  // pollset entry: report only after the object has changed (edge-triggered)
+
+#define POLL_ADD (1) // pollset_ctl operations
+#define POLL_MOD (2)
+#define POLL_DEL (3)
+
+#define POLL_TIMEOUT_MAX (89000) // longest timeout in ms (deadlines are 2^31 ticks of the 24 MHz counter)
+
+#define IPC_WORDS (8) // words in a call/reply message (carried in r1-r8)
+#define IPC_NONE (-3) // ipc_reply_wait: nobody to reply to (not a PID: the console's is -1)
+
+/* Kernel objects (semaphores, shared memory, kernel mutexes, condition
+ * variables, barriers and reader-writer locks) are named by handles:
+ * small integers the kernel checks on every use, so a handle to an
+ * object that has been destroyed is rejected. -1 is never a handle.
+ */
+
+/* A semaphore is a word in user space plus the handle of the kernel
+ * object that queues its waiters. value >= 0 is the count, < 0 minus
+ * the number of processes blocked on it; sem_wait/sem_post update it
+ * with LDREX/STREX and only trap into the kernel to block or to wake
+ * a blocked process.
+ */
+typedef struct
+{
+    int value;
+    int handle;
+    int acquired; // fast path sem_waits (counted only with -DKERNEL_LOCK_STATS, for lockstat)
+} sem_t;
 
-typedef int *sem_t;
+/* One operation of a semop vector: op > 0 posts op units, op < 0 takes
+ * -op units (each sem_t may appear at most once in a vector).
+ */
+typedef struct
+{
+    sem_t *sem;
+    int op;
+} sembuf_t;
+
+/* A mutex is a word in user space: 0 unlocked, 1 locked, 2 locked with
+ * (possible) waiters, who sleep on it with futex_wait.
+ */
+typedef int mutex_t;
+
+#define MUTEX_INITIALIZER (0)
+
+/* A kernel mutex is owned by the kernel (every lock/unlock is a system
+ * call), which lends the owner the priority of any process it blocks.
+ */
+typedef int kmutex_t;
+
+/* Condition variables, barriers and reader-writer locks are owned by the
+ * kernel, which blocks waiters on them (the creator's exit destroys them).
+ */
+typedef int cond_t;
+typedef int barrier_t;
+typedef int rwlock_t;
 
+/* Pipes and channels are bounded kernel ring buffers: a pipe carries a
+ * stream of bytes, a channel fixed-size messages. Readers block while
+ * one is empty and writers while it is full, unless IPC_NONBLOCK is
+ * passed; they are destroyed when their creator exits.
+ */
+typedef int pipe_t;
+typedef int chan_t;
+
+/* poll waits for any of several handles (semaphores, pipes, channels)
+ * to be ready, or a timeout in ms (as fine as the scheduler tick, and
+ * at most POLL_TIMEOUT_MAX: a longer one fails with -1);
+ * a pollset keeps the interest list in the kernel between waits.
+ * Polling a semaphore waits for it as sem_wait would: POLLIN means the
+ * poll took it (at most one per call).
+ */
+typedef struct
+{
+    int handle;
+    uint16_t events;  // POLLIN/POLLOUT (and POLLET) wanted
+    uint16_t revents; // events ready
+} pollfd_t;
+
+typedef int pollset_t;
+
+/* An asynchronous I/O ring (after Linux io_uring): the program fills
+ * submission queue entries and advances sqTail, the kernel takes them
+ * (on io_enter, or every tick with IORING_SQPOLL) and, as each operation
+ * finishes, appends a completion to the completion queue and advances
+ * cqTail; the program reaps completions by advancing cqHead. Both queues
+ * have entries slots (a power of two) and live in the program's memory.
+ * An operation on a descriptor that isn't ready waits in the kernel
+ * without blocking the program; operations on one descriptor finish in
+ * the order they were submitted. Disk operations only run during the
+ * program's own io_enter (the disk holds the kernel for the transfer).
+ */
 typedef struct
 {
-    int owner; // PID of owner
+    uint8_t op;        // IORING_OP_X
+    uint8_t rsvd[3];
+    int fd;
+    void *buf;
+    uint32_t len;
+    uint32_t userData; // returned in the completion
+} io_sqe_t;
+
+typedef struct
+{
+    uint32_t userData;
+    int res; // as read or write would return
+} io_cqe_t;
+
+typedef struct
+{
+    volatile uint32_t sqHead; // next submission the kernel takes
+    volatile uint32_t sqTail; // next submission the program fills
+    volatile uint32_t cqHead; // next completion the program reaps
+    volatile uint32_t cqTail; // next completion the kernel fills
+    uint32_t entries;
+    uint32_t flags; // IORING_SQPOLL
+    io_sqe_t *sq;
+    io_cqe_t *cq;
+} io_ring_t;
+
+/* A synchronous call/reply message: ipc_call sends one to a server
+ * process and blocks until it replies; the server loops on
+ * ipc_reply_wait, which replies to one client and waits for the next.
+ * The words travel in registers, and the kernel switches straight
+ * between client and server when the other side is already waiting.
+ */
+typedef struct
+{
+    uint32_t w[IPC_WORDS];
+} ipc_msg_t;
+
+/* The heap allocator keeps per-process state at the base of the heap
+ * (found via TPIDRURO, so it never needs a syscall to locate it): one
+ * free list per size class, refilled in batches carved from memory
+ * obtained with sbrk, plus a first-fit list of freed large blocks.
+ */
+
+#define MALLOC_CLASSES (8)            // block sizes 16, 32, ..., 2048 bytes (incl. header)
+#define MALLOC_MIN (16)
+#define MALLOC_BATCH (8)              // blocks carved per size class refill
+#define MALLOC_CHUNK (0x00004000)     // bytes requested from sbrk per refill
+#define MALLOC_LARGE (MALLOC_CLASSES) // size class of blocks > 2048 bytes
+
+typedef struct malloc_block
+{
+    struct malloc_block *next;
+} malloc_block_t;
+
+typedef struct
+{
+    uint32_t size;  // block length (incl. header)
+    uint32_t class; // size class (MALLOC_LARGE if large)
+} malloc_header_t;
+
+typedef struct
+{
+    malloc_block_t *freeLists[MALLOC_CLASSES];
+    malloc_block_t *large; // freed large blocks
+    uint8_t *top;          // next byte to carve
+    uint8_t *end;          // end of the memory obtained from sbrk
+} malloc_arena_t;
+
+typedef struct shm
+{
+    int owner; // PID of creator
+    int handle;
+    int key;
     size_t size;
-    void *addr; // address of shared mem space
+    void *addr;       // address of shared mem space (page aligned)
+    int refs;         // processes attached; freed when it drops to 0
+    uint32_t users;   // process table slots attached (MAX_PROCS <= 32)
+    struct shm *next; // next entry in the (kernel) shmTable chain
 } shm_t;
 
 // convert ASCII string x into integer r
@@ -78,10 +319,14 @@ extern void itoaLocal(char *r, int x);
 // cooperatively yield control of processor, i.e., invoke the scheduler
 extern void yield(pid_t pid);
 
-// write n bytes from x to   the file descriptor fd; return bytes written
+// write n bytes from x to   the file descriptor fd (blocking only while a UART's output buffer
+// or a pipe is full); return bytes written (fewer at the end of a segment or the disk)
 extern int write(int fd, const void *x, size_t n);
-// read  n bytes into x from the file descriptor fd; return bytes read
+// read  up to n bytes into x from the file descriptor fd, blocking until any arrive; return bytes read
 extern int read(int fd, void *x, size_t n);
+// as read, but give up after timeout ms (< 0 for ever, 0 not at all; as fine as the scheduler tick),
+// returning 0 (-1 if timeout is over POLL_TIMEOUT_MAX)
+extern int read_timeout(int fd, void *x, size_t n, int timeout);
 
 // perform fork, returning 0 iff. child or > 0 iff. parent process
 extern int fork();
@@ -102,6 +347,9 @@ extern void pause(pid_t pid);
 
 // for process identified by pid, resumes execution and scheduling but remains in processTable
 extern void unpause(pid_t pid);
+// on: whenever this process wakes another (sem_post, pipes, ...), switch to it at once; otherwise only
+// when the woken process is the more urgent
+extern void sched_handoff(bool on);
 
 // shows the status of the process table (entries)
 extern void status();
@@ -114,12 +362,128 @@ extern void close(int x);
 // return gpr[0]
 extern int getaddr();
 
-extern void *shm_init(size_t size);
-extern void shm_destroy(void *addr);
-extern void shm_write(void *addr, int data, size_t dataSize);
-extern sem_t sem_init();
-extern void sem_destroy(sem_t sem);
-extern void sem_post(sem_t sem);
-extern int sem_wait(sem_t sem);
+// shows the usage of the kernel slab caches
+extern void slabs();
+
+// shows the free block count of every order of the page allocator
+extern void pages();
+
+// shows the kernel heap totals, free chunk histogram and allocation call-sites
+extern void memstat();
+// print the n semaphores with the most time spent waiting on them (needs -DKERNEL_LOCK_STATS)
+extern void lockstat(int n);
+
+// set the program break to addr; return 0 on success, -1 on failure
+extern int brk(void *addr);
+// move the program break by incr bytes; return the previous break, or (void *)-1 on failure
+extern void *sbrk(int incr);
+
+// allocate / free heap memory (suffixed like atoiLocal to keep clear of the kernel's newlib allocator)
+extern void *mallocLocal(size_t size);
+extern void *callocLocal(size_t n, size_t size);
+extern void *reallocLocal(void *x, size_t size);
+extern void freeLocal(void *x);
+
+// open (or create, zeroed) the segment with key of at least size bytes, attaching to it and setting *addr to its
+// address; SHM_PRIVATE always creates a new segment; returns its handle (-1 on failure)
+extern int shm_open(int key, size_t size, void **addr);
+// attach to an open segment by handle, returning its address (NULL on failure)
+extern void *shm_attach(int shm);
+// detach from a segment (freed once every process has detached or exited); 0, or -1 if not attached
+extern int shm_detach(int shm);
+// initialise *sem (value 0); return 0, or -1 on failure
+extern int sem_init(sem_t *sem);
+extern void sem_destroy(sem_t *sem);
+extern void sem_post(sem_t *sem);
+extern int sem_wait(sem_t *sem);
+// apply the n ops atomically, blocking until every decrement can proceed at once; 0, or -1 on error
+extern int semop(sembuf_t *ops, int n);
+
+// atomically (LDREX/STREX): set *addr to desired if it holds expected, add x to *addr, or set *addr to x; each returns the old value
+extern int atomicCas(int *addr, int expected, int desired);
+extern int atomicAdd(int *addr, int x);
+extern int atomicSwap(int *addr, int x);
+
+// sleep while *addr == expected (until futex_wake( addr, ... )); return 0 if woken, -1 if *addr != expected
+extern int futex_wait(int *addr, int expected);
+// wake up to n processes sleeping on addr; return the number woken
+extern int futex_wake(int *addr, int n);
+
+extern void mutex_init(mutex_t *mutex);
+extern void mutex_lock(mutex_t *mutex);
+extern bool mutex_trylock(mutex_t *mutex);
+extern void mutex_unlock(mutex_t *mutex);
+
+// kernel mutexes with priority inheritance; lock/unlock return 0, or -1 on error (or if destroyed while waiting)
+extern kmutex_t kmutex_init();
+extern void kmutex_destroy(kmutex_t mutex);
+extern int kmutex_lock(kmutex_t mutex);
+extern int kmutex_unlock(kmutex_t mutex);
+
+// condition variables (used with a mutex_t); signal/broadcast return the number of processes woken
+extern cond_t cond_init();
+extern void cond_destroy(cond_t cond);
+extern int cond_wait(cond_t cond, mutex_t *mutex);
+extern int cond_signal(cond_t cond);
+extern int cond_broadcast(cond_t cond);
+
+// N-party barriers; barrier_wait returns 1 in the last process to arrive, 0 in the others
+extern barrier_t barrier_init(int parties);
+extern void barrier_destroy(barrier_t barrier);
+extern int barrier_wait(barrier_t barrier);
+
+// reader-writer locks (writers are preferred); each returns 0, or -1 on error (e.g. locking one already held)
+extern rwlock_t rwlock_init();
+extern void rwlock_destroy(rwlock_t rwlock);
+extern int rwlock_rdlock(rwlock_t rwlock);
+extern int rwlock_wrlock(rwlock_t rwlock);
+extern int rwlock_unlock(rwlock_t rwlock);
+
+// pipes (size 0 for PIPE_SIZE bytes); write returns n (or bytes written with IPC_NONBLOCK),
+// read returns 1..n bytes; both return IPC_AGAIN if IPC_NONBLOCK would block, -1 on error
+extern pipe_t pipe_init(size_t size);
+extern void pipe_destroy(pipe_t pipe);
+extern int pipe_write(pipe_t pipe, const void *x, size_t n, int flags);
+extern int pipe_read(pipe_t pipe, void *x, size_t n, int flags);
+
+// channels of slots messages of msgSize bytes; send/recv move one whole message
+extern chan_t chan_init(size_t msgSize, int slots);
+extern int chan_send(chan_t chan, const void *msg, int flags);
+extern int chan_recv(chan_t chan, void *msg, int flags);
+
+// wait up to timeout ms (< 0 for ever, 0 not at all) for any of fds to be ready, returning how many are (0 on timeout)
+extern int poll(pollfd_t *fds, int n, int timeout);
+// persistent interest sets: pollset_wait copies up to max ready entries to out and returns how many (-1 on error)
+extern pollset_t pollset_init();
+extern void pollset_destroy(pollset_t set);
+extern int pollset_ctl(pollset_t set, int op, int handle, int events);
+extern int pollset_wait(pollset_t set, pollfd_t *out, int max, int timeout);
+
+// synchronous IPC: ipc_call replaces msg with the reply (0, or -1 if dest doesn't exist or exits);
+// ipc_reply_wait replies with msg to replyTo (unless IPC_NONE), then replaces it with the next
+// request and returns the PID of its caller (which is -1 for the console)
+extern int ipc_call(pid_t dest, ipc_msg_t *msg);
+extern pid_t ipc_reply_wait(pid_t replyTo, ipc_msg_t *msg);
+
+// descriptors (MAX_FDS per process, shared with a fork): fd_open returns the lowest free one
+// on an object of kind FILE_X (-1 on error); dup2 makes newfd name what oldfd does (e.g.,
+// a FILE_NULL descriptor as STDOUT_FILENO silences a process) and returns newfd; fd_seek moves
+// the offset of a segment or disk descriptor; fd_close and fd_seek return 0, or -1 on error
+extern int fd_open(int kind, int arg);
+extern int fd_close(int fd);
+extern int dup2(int oldfd, int newfd);
+extern int fd_seek(int fd, size_t offset);
+// switch the disk to protocol DISK_X (the kernel asks for DISK_BIN when the disk is first opened),
+// returning the protocol now in use (DISK_HEX if the disk only speaks that)
+extern int disk_set_mode(int mode);
+
+// asynchronous I/O: io_setup registers ring (entries, flags, sq and cq set; one per process);
+// io_enter hands the kernel every submission up to sqTail and waits until at least minComplete
+// completions are unreaped, returning how many are (-1 on error); io_submit and io_reap are the
+// program's side of the queues (io_submit returns false if the submission queue is full)
+extern int io_setup(io_ring_t *ring);
+extern int io_enter(int minComplete);
+extern bool io_submit(io_ring_t *ring, int op, int fd, void *buf, uint32_t len, uint32_t userData);
+extern bool io_reap(io_ring_t *ring, io_cqe_t *cqe);
 
 #endif
@@ -0,0 +1,61 @@
+#include "mallocBench.h"
+
+#define MALLOC_BENCH_OPS (100000)
+#define MALLOC_BENCH_LIVE (256)
+
+void *liveBlocks[MALLOC_BENCH_LIVE];
+
+/*  malloc/free throughput of the user heap allocator:
+    1. alloc then free one block at a time (free list hit every time),
+    2. alloc MALLOC_BENCH_LIVE blocks of mixed sizes then free them all,
+    3. large (> 2 KiB) blocks, reused first-fit,
+    4. baseline: one sbrk( 0 ) trap per op, i.e., what every allocation would cost if it entered the kernel.  */
+void main_mallocBench()
+{
+  uint32_t t;
+
+  t = benchTime();
+  for (int i = 0; i < MALLOC_BENCH_OPS; i++)
+  {
+    void *x = mallocLocal(16 + (i & 0xFF));
+    freeLocal(x);
+  }
+  benchReport("malloc+free (same block)", MALLOC_BENCH_OPS, benchTime() - t);
+
+  t = benchTime();
+  for (int i = 0; i < MALLOC_BENCH_OPS / MALLOC_BENCH_LIVE; i++)
+  {
+    for (int j = 0; j < MALLOC_BENCH_LIVE; j++)
+    {
+      liveBlocks[j] = mallocLocal(8 << (j & 0x7));
+    }
+    for (int j = 0; j < MALLOC_BENCH_LIVE; j++)
+    {
+      freeLocal(liveBlocks[j]);
+    }
+  }
+  benchReport("malloc+free (256 live, mixed)", (MALLOC_BENCH_OPS / MALLOC_BENCH_LIVE) * MALLOC_BENCH_LIVE, benchTime() - t);
+
+  t = benchTime();
+  for (int i = 0; i < MALLOC_BENCH_OPS / 16; i++)
+  {
+    for (int j = 0; j < 16; j++)
+    {
+      liveBlocks[j] = mallocLocal(4096 << (j & 0x1));
+    }
+    for (int j = 0; j < 16; j++)
+    {
+      freeLocal(liveBlocks[j]);
+    }
+  }
+  benchReport("malloc+free (large)", (MALLOC_BENCH_OPS / 16) * 16, benchTime() - t);
+
+  t = benchTime();
+  for (int i = 0; i < MALLOC_BENCH_OPS; i++)
+  {
+    sbrk(0);
+  }
+  benchReport("sbrk(0) syscall", MALLOC_BENCH_OPS, benchTime() - t);
+
+  exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,11 @@
+#ifndef __MALLOCBENCH_H
+#define __MALLOCBENCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libc.h"
+#include "bench.h"
+
+#endif
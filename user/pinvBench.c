@@ -0,0 +1,127 @@
+#include "pinvBench.h"
+
+//  P3-style spinners competing with the lock holder
+#define PINV_SPINNERS (4)
+//  times the waiter takes the lock per phase
+#define PINV_ROUNDS (32)
+//  weight() iterations per critical section of the holder, and between the waiter's locks
+#define PINV_HOLD (1 << 16)
+#define PINV_GAP (1 << 12)
+
+//  shared by the forked processes (no MMU)
+mutex_t pinvMutex = MUTEX_INITIALIZER;
+kmutex_t pinvKmutex;
+
+extern uint32_t weight(uint32_t x);
+
+void pinvSpin(uint32_t n)
+{
+  for (uint32_t x = 0; x < n; x++)
+  {
+    weight(x);
+  }
+}
+
+void pinvLock(bool inherit)
+{
+  if (inherit)
+  {
+    kmutex_lock(pinvKmutex);
+  }
+  else
+  {
+    mutex_lock(&pinvMutex);
+  }
+}
+
+void pinvUnlock(bool inherit)
+{
+  if (inherit)
+  {
+    kmutex_unlock(pinvKmutex);
+  }
+  else
+  {
+    mutex_unlock(&pinvMutex);
+  }
+}
+
+//  the low priority holder: demoted by the MLFQ (it never blocks), then takes the lock for long critical sections
+void pinvHolder(bool inherit)
+{
+  pinvSpin(PINV_HOLD << 4);
+  while (1)
+  {
+    pinvLock(inherit);
+    pinvSpin(PINV_HOLD);
+    pinvUnlock(inherit);
+  }
+}
+
+void pinvSpinner()
+{
+  while (1)
+  {
+    pinvSpin(PINV_HOLD);
+  }
+}
+
+/*  run one phase: fork the holder and the spinners, then (as the high priority waiter)
+    time PINV_ROUNDS acquisitions of the lock and report the latency  */
+void pinvPhase(char *label, bool inherit)
+{
+  pid_t pids[PINV_SPINNERS + 1];
+  uint32_t total = 0;
+  uint32_t max = 0;
+
+  pids[0] = fork();
+  if (pids[0] == 0)
+  {
+    pinvHolder(inherit);
+  }
+  for (int i = 1; i <= PINV_SPINNERS; i++)
+  {
+    pids[i] = fork();
+    if (pids[i] == 0)
+    {
+      pinvSpinner();
+    }
+  }
+
+  for (int r = 0; r < PINV_ROUNDS; r++)
+  {
+    uint32_t t = benchTime();
+    pinvLock(inherit);
+    t = benchTime() - t;
+    pinvUnlock(inherit);
+
+    total += t;
+    if (t > max)
+    {
+      max = t;
+    }
+    pinvSpin(PINV_GAP);
+  }
+
+  for (int i = 0; i <= PINV_SPINNERS; i++)
+  {
+    kill(pids[i], EXIT_SUCCESS);
+  }
+  benchLatency(label, PINV_ROUNDS, total, max);
+}
+
+/*  priority inversion: a lock held by a demoted process, wanted by an interactive one,
+    while CPU-bound spinners sit in the levels between them; compares the waiter's
+    latency on a futex mutex_t (no inheritance) with a kernel kmutex_t (inheritance)  */
+void main_pinvBench()
+{
+  pinvKmutex = kmutex_init();
+
+  pinvPhase("mutex_t lock latency (no inheritance)", false);
+  //  the holder may have been killed holding it
+  mutex_init(&pinvMutex);
+  pinvPhase("kmutex_t lock latency (inheritance)", true);
+
+  kmutex_destroy(pinvKmutex);
+  exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,11 @@
+#ifndef __PINVBENCH_H
+#define __PINVBENCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libc.h"
+#include "bench.h"
+
+#endif
@@ -0,0 +1,94 @@
+#include "pipeBench.h"
+#include <string.h>
+
+//  bytes streamed through the pipe, in writes and reads of PIPE_CHUNK bytes
+#define PIPE_BYTES (1 << 20)
+#define PIPE_CHUNK (256)
+//  messages sent over the channel, of CHAN_MSG bytes with CHAN_SLOTS buffered
+#define CHAN_MSGS (1 << 14)
+#define CHAN_MSG (16)
+#define CHAN_SLOTS (64)
+
+//  shared by the forked processes (no MMU)
+pipe_t benchPipe;
+chan_t benchChan;
+
+void pipeConsumer()
+{
+  uint8_t x[PIPE_CHUNK];
+  uint32_t got = 0;
+
+  while (got < PIPE_BYTES)
+  {
+    int r = pipe_read(benchPipe, x, PIPE_CHUNK, 0);
+    if (r < 0)
+    {
+      break;
+    }
+    got += r;
+  }
+  exit(EXIT_SUCCESS);
+}
+
+void chanConsumer()
+{
+  uint8_t msg[CHAN_MSG];
+
+  for (int i = 0; i < CHAN_MSGS; i++)
+  {
+    if (chan_recv(benchChan, msg, 0) < 0)
+    {
+      break;
+    }
+  }
+  exit(EXIT_SUCCESS);
+}
+
+/*  producer/consumer throughput: the parent writes, a forked child reads; the clock
+    stops once the parent has handed over the last byte (or message), at most one
+    ring's worth ahead of the child, which exits when the object is destroyed  */
+void main_pipeBench()
+{
+  uint8_t x[PIPE_CHUNK];
+  memset(x, 0xA5, sizeof(x));
+
+  benchPipe = pipe_init(0);
+  if (benchPipe < 0)
+  {
+    exit(EXIT_FAILURE);
+  }
+  pid_t pid = fork();
+  if (pid == 0)
+  {
+    pipeConsumer();
+  }
+  uint32_t t = benchTime();
+  for (uint32_t sent = 0; sent < PIPE_BYTES; sent += PIPE_CHUNK)
+  {
+    pipe_write(benchPipe, x, PIPE_CHUNK, 0);
+  }
+  t = benchTime() - t;
+  benchThroughput("pipe (256-byte writes)", PIPE_BYTES, t);
+  pipe_destroy(benchPipe);
+
+  benchChan = chan_init(CHAN_MSG, CHAN_SLOTS);
+  if (benchChan < 0)
+  {
+    exit(EXIT_FAILURE);
+  }
+  pid = fork();
+  if (pid == 0)
+  {
+    chanConsumer();
+  }
+  t = benchTime();
+  for (int i = 0; i < CHAN_MSGS; i++)
+  {
+    chan_send(benchChan, x, 0);
+  }
+  t = benchTime() - t;
+  benchReport("channel (16-byte messages)", CHAN_MSGS, t);
+  pipe_destroy(benchChan);
+
+  exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,11 @@
+#ifndef __PIPEBENCH_H
+#define __PIPEBENCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libc.h"
+#include "bench.h"
+
+#endif
@@ -0,0 +1,166 @@
+#include "ring.h"
+#include <string.h>
+
+//  order the accesses to the ring before the barrier against those after it
+#define ringBarrier() asm volatile("dmb" : : : "memory")
+
+size_t ring_bytes(uint32_t slots, uint32_t elemSize)
+{
+  return sizeof(ring_t) + (size_t)slots * elemSize;
+}
+
+ring_t *ring_init(void *mem, uint32_t slots, uint32_t elemSize, int flags)
+{
+  if (slots == 0 || (slots & (slots - 1)) != 0 || ((uint32_t)mem & (RING_CACHE_LINE - 1)) != 0)
+  {
+    return NULL;
+  }
+  ring_t *ring = mem;
+  memset(ring, 0, sizeof(ring_t));
+  ring->slots = slots;
+  ring->elemSize = elemSize;
+  ring->flags = flags;
+
+  return ring;
+}
+
+//  claim up to n slots from index (bounded by the avail slots before limit), returning how many and setting *start
+uint32_t ringClaim(ring_t *ring, ring_index_t *index, volatile uint32_t *limit, uint32_t capacity, uint32_t n, uint32_t *start)
+{
+  uint32_t head = index->head;
+
+  while (1)
+  {
+    //  free slots for producers (capacity = slots), published elements for consumers (capacity = 0)
+    uint32_t avail = capacity + *limit - head;
+    uint32_t claim = (n < avail) ? n : avail;
+    if (claim == 0)
+    {
+      return 0;
+    }
+    if (ring->flags != RING_MPMC)
+    {
+      index->head = head + claim;
+      *start = head;
+      return claim;
+    }
+    uint32_t seen = (uint32_t)atomicCas((int *)&index->head, (int)head, (int)(head + claim));
+    if (seen == head)
+    {
+      *start = head;
+      return claim;
+    }
+    head = seen;
+  }
+}
+
+/*  sleep until index->tail moves on from seen (returning at once if it already has)
+      -by one side waiting for the other, or by an MPMC process waiting for an earlier claim
+      -sleepers is raised before the kernel checks the tail again, so a publish can't be missed  */
+void ringSleep(ring_index_t *index, uint32_t seen)
+{
+  atomicAdd((int *)&index->sleepers, 1);
+  futex_wait((int *)&index->tail, (int)seen);
+  atomicAdd((int *)&index->sleepers, -1);
+}
+
+/*  publish the claimed slots [start, start + n) of index once every earlier claim has been,
+    then wake the other side if it is sleeping on this index  */
+void ringPublish(ring_index_t *index, uint32_t start, uint32_t n)
+{
+  //  an earlier claim (by another process) is still copying: let it finish
+  uint32_t tail;
+  while ((tail = index->tail) != start)
+  {
+    ringSleep(index, tail);
+  }
+  ringBarrier();
+  index->tail = start + n;
+  ringBarrier();
+  if (index->sleepers != 0)
+  {
+    futex_wake((int *)&index->tail, index->sleepers);
+  }
+}
+
+//  copy n elements between the slots from start and x, wrapping at most once
+void ringCopy(ring_t *ring, uint32_t start, void *x, uint32_t n, bool in)
+{
+  uint32_t first = ring->slots - (start & (ring->slots - 1));
+  if (first > n)
+  {
+    first = n;
+  }
+  uint8_t *slot = ring->elems + (start & (ring->slots - 1)) * ring->elemSize;
+  size_t a = first * ring->elemSize;
+  size_t b = (n - first) * ring->elemSize;
+
+  if (in)
+  {
+    memcpy(slot, x, a);
+    memcpy(ring->elems, (uint8_t *)x + a, b);
+  }
+  else
+  {
+    memcpy(x, slot, a);
+    memcpy((uint8_t *)x + a, ring->elems, b);
+  }
+}
+
+uint32_t ring_enqueue_burst(ring_t *ring, const void *elems, uint32_t n)
+{
+  uint32_t start;
+  uint32_t claim = ringClaim(ring, &ring->prod, &ring->cons.tail, ring->slots, n, &start);
+
+  if (claim != 0)
+  {
+    ringCopy(ring, start, (void *)elems, claim, true);
+    ringPublish(&ring->prod, start, claim);
+  }
+  return claim;
+}
+
+uint32_t ring_dequeue_burst(ring_t *ring, void *elems, uint32_t n)
+{
+  uint32_t start;
+  uint32_t claim = ringClaim(ring, &ring->cons, &ring->prod.tail, 0, n, &start);
+
+  if (claim != 0)
+  {
+    ringCopy(ring, start, elems, claim, false);
+    ringPublish(&ring->cons, start, claim);
+  }
+  return claim;
+}
+
+void ring_send(ring_t *ring, const void *elems, uint32_t n)
+{
+  const uint8_t *x = elems;
+
+  while (n != 0)
+  {
+    uint32_t seen = ring->cons.tail;
+    uint32_t moved = ring_enqueue_burst(ring, x, n);
+    if (moved == 0)
+    {
+      ringSleep(&ring->cons, seen);
+    }
+    x += moved * ring->elemSize;
+    n -= moved;
+  }
+}
+
+uint32_t ring_recv(ring_t *ring, void *elems, uint32_t n)
+{
+  while (n != 0)
+  {
+    uint32_t seen = ring->prod.tail;
+    uint32_t moved = ring_dequeue_burst(ring, elems, n);
+    if (moved != 0)
+    {
+      return moved;
+    }
+    ringSleep(&ring->prod, seen);
+  }
+  return 0;
+}
@@ -0,0 +1,60 @@
+#ifndef __RING_H
+#define __RING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libc.h"
+
+/* A lock-free ring of fixed-size elements, kept wholly in memory shared
+ * by its users (a shared memory segment): enqueue and dequeue never enter
+ * the kernel, except to sleep on an empty or full ring (futex_wait) and
+ * to wake a sleeper (futex_wake).
+ *
+ * Producers claim slots by advancing prod.head (a plain store for
+ * RING_SPSC, LDREX/STREX for RING_MPMC), copy their elements in, then
+ * publish them in claim order by advancing prod.tail; consumers do the
+ * same with cons.head/cons.tail. Each index lives on its own cache line
+ * so producers and consumers don't share one.
+ */
+
+#define RING_CACHE_LINE (64)
+
+#define RING_SPSC (0) // one producer and one consumer process
+#define RING_MPMC (1) // any number of each
+
+typedef struct
+{
+  volatile uint32_t head; // next slot to claim
+  volatile uint32_t tail; // slots before this are published
+  volatile int sleepers;  // processes sleeping for the other side to move
+  uint8_t pad[RING_CACHE_LINE - 3 * sizeof(uint32_t)];
+} ring_index_t;
+
+typedef struct
+{
+  uint32_t slots; // a power of 2
+  uint32_t elemSize;
+  int flags;
+  uint8_t pad[RING_CACHE_LINE - 3 * sizeof(uint32_t)];
+  ring_index_t prod;
+  ring_index_t cons;
+  uint8_t elems[]; // slots * elemSize bytes
+} ring_t;
+
+// bytes of memory needed for a ring of slots (a power of 2) elements of elemSize bytes
+extern size_t ring_bytes(uint32_t slots, uint32_t elemSize);
+// lay an empty ring out in mem (cache-line aligned, ring_bytes long); NULL if slots isn't a power of 2
+extern ring_t *ring_init(void *mem, uint32_t slots, uint32_t elemSize, int flags);
+
+// enqueue/dequeue up to n elements without blocking, returning how many were moved
+extern uint32_t ring_enqueue_burst(ring_t *ring, const void *elems, uint32_t n);
+extern uint32_t ring_dequeue_burst(ring_t *ring, void *elems, uint32_t n);
+
+// enqueue all n elements, sleeping while the ring is full
+extern void ring_send(ring_t *ring, const void *elems, uint32_t n);
+// dequeue 1..n elements, sleeping while the ring is empty; returns how many were moved
+extern uint32_t ring_recv(ring_t *ring, void *elems, uint32_t n);
+
+#endif
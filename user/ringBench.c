@@ -0,0 +1,92 @@
+#include "ringBench.h"
+
+//  messages per phase, of one word each, through a ring of RING_SLOTS
+#define RING_MSGS (1 << 20)
+#define RING_SLOTS (1024)
+//  elements per ring_send/ring_recv in the batched phases
+#define RING_BATCH (32)
+//  producers and consumers in the MPMC phase
+#define RING_PROCS (2)
+
+//  shared by the forked processes (no MMU)
+ring_t *benchRing;
+sem_t ringDone;
+
+//  receive count messages in batches of batch, then post ringDone
+void ringConsumer(uint32_t count, uint32_t batch)
+{
+  uint32_t x[RING_BATCH];
+
+  while (count != 0)
+  {
+    count -= ring_recv(benchRing, x, (batch < count) ? batch : count);
+  }
+  sem_post(&ringDone);
+  exit(EXIT_SUCCESS);
+}
+
+void ringProducer(uint32_t count, uint32_t batch)
+{
+  uint32_t x[RING_BATCH];
+
+  for (uint32_t i = 0; i < RING_BATCH; i++)
+  {
+    x[i] = i;
+  }
+  for (; count != 0; count -= batch)
+  {
+    ring_send(benchRing, x, batch);
+  }
+}
+
+/*  one phase: lay the ring out afresh, fork the producers (all but the parent) and consumers,
+    produce the parent's share, then wait for every consumer to finish  */
+void ringPhase(char *label, void *mem, int flags, int procs, uint32_t batch)
+{
+  uint32_t share = RING_MSGS / procs;
+
+  benchRing = ring_init(mem, RING_SLOTS, sizeof(uint32_t), flags);
+  uint32_t t = benchTime();
+
+  for (int i = 0; i < procs; i++)
+  {
+    if (fork() == 0)
+    {
+      ringConsumer(share, batch);
+    }
+  }
+  for (int i = 1; i < procs; i++)
+  {
+    if (fork() == 0)
+    {
+      ringProducer(share, batch);
+      exit(EXIT_SUCCESS);
+    }
+  }
+  ringProducer(share, batch);
+  for (int i = 0; i < procs; i++)
+  {
+    sem_wait(&ringDone);
+  }
+  benchReport(label, RING_MSGS, benchTime() - t);
+}
+
+/*  message throughput through a ring in a shared memory segment: one at a time
+    and batched between a producer and a consumer, then RING_PROCS of each  */
+void main_ringBench()
+{
+  void *mem;
+  int shm = shm_open(SHM_PRIVATE, ring_bytes(RING_SLOTS, sizeof(uint32_t)), &mem);
+
+  if (shm < 0 || sem_init(&ringDone) < 0)
+  {
+    exit(EXIT_FAILURE);
+  }
+  ringPhase("ring SPSC", mem, RING_SPSC, 1, 1);
+  ringPhase("ring SPSC (batches of 32)", mem, RING_SPSC, 1, RING_BATCH);
+  ringPhase("ring MPMC 2x2 (batches of 32)", mem, RING_MPMC, RING_PROCS, RING_BATCH);
+
+  sem_destroy(&ringDone);
+  shm_detach(shm);
+  exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,12 @@
+#ifndef __RINGBENCH_H
+#define __RINGBENCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libc.h"
+#include "bench.h"
+#include "ring.h"
+
+#endif